@@ -0,0 +1,82 @@
+// Host-side benchmark for convert_uni_to_ds4().
+//
+// Checks that the table-driven packer is byte-identical to the reference
+// implementation over random gamepads, then reports the cost of each.
+//
+// Build from the repository root:
+//   cc -O2 -I. -Ilib2/bluepad32/src/components/bluepad32/include bench/bench_convert.c dualshock4.c -o bench_convert
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "dualshock4.h"
+
+#define NUM_SAMPLES 4096
+#define NUM_ROUNDS 2000
+
+typedef void (*convert_fn_t)(const uni_gamepad_t gamepad, const uint8_t battery, ds4_report_t* ds4);
+
+static uni_gamepad_t samples[NUM_SAMPLES];
+static uint8_t batteries[NUM_SAMPLES];
+
+static int32_t rand_range(int32_t min, int32_t max) {
+  return min + rand() % (max - min + 1);
+}
+
+static void fill_samples(void) {
+  srand(1234);
+  for (int i = 0; i < NUM_SAMPLES; i++) {
+    uni_gamepad_t* gp = &samples[i];
+    memset(gp, 0, sizeof(*gp));
+    gp->dpad = rand() & 0x0F;
+    gp->axis_x = rand_range(-512, 511);
+    gp->axis_y = rand_range(-512, 511);
+    gp->axis_rx = rand_range(-512, 511);
+    gp->axis_ry = rand_range(-512, 511);
+    gp->brake = rand_range(0, 1020);
+    gp->throttle = rand_range(0, 1020);
+    gp->buttons = rand() & 0x03FF;
+    gp->misc_buttons = rand() & 0x0F;
+    for (int j = 0; j < 3; j++) {
+      gp->gyro[j] = rand_range(-32768, 32767);
+      gp->accel[j] = rand_range(-32768, 32767);
+    }
+    batteries[i] = rand_range(0, 251);
+  }
+}
+
+static void bench(const char* name, convert_fn_t fn) {
+  static ds4_report_t out;
+  bench_timer_t t;
+  bench_start(&t);
+  for (int r = 0; r < NUM_ROUNDS; r++) {
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+      fn(samples[i], batteries[i], &out);
+      __asm volatile("" : : "r"(&out) : "memory");
+    }
+  }
+  bench_report(&t, name, "conv", (double)NUM_ROUNDS * NUM_SAMPLES);
+}
+
+int main(void) {
+  fill_samples();
+
+  for (int i = 0; i < NUM_SAMPLES; i++) {
+    ds4_report_t want, got;
+    memset(&want, 0xAA, sizeof(want));
+    memset(&got, 0x55, sizeof(got));
+    convert_uni_to_ds4_reference(samples[i], batteries[i], &want);
+    convert_uni_to_ds4(samples[i], batteries[i], &got);
+    if (memcmp(&want, &got, sizeof(want)) != 0) {
+      fprintf(stderr, "mismatch at sample %d\n", i);
+      return 1;
+    }
+  }
+  printf("%d samples byte-identical\n", NUM_SAMPLES);
+
+  bench("reference", convert_uni_to_ds4_reference);
+  bench("table", convert_uni_to_ds4);
+  return 0;
+}
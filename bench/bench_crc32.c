@@ -0,0 +1,72 @@
+// Host-side benchmark for the software CRC32 engines (uni_utils.c).
+//
+// Checks that the slice-by-4 tables match the bitwise reference over random
+// buffers, seeds and lengths, then reports the cost of each on DS4-sized
+// reports. The DMA sniffer engine only exists on the RP2350: crc_engine_init()
+// times all engines there and logs them at boot.
+//
+// Build from the repository root:
+//   cc -O2 -Ilib2/bluepad32/src/components/bluepad32/include bench/bench_crc32.c
+//      lib2/bluepad32/src/components/bluepad32/uni_utils.c -o bench_crc32
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_util.h"
+#include "uni_utils.h"
+
+#define NUM_SAMPLES 4096
+#define NUM_ROUNDS 200
+#define MAX_LEN 96
+#define OUTPUT_REPORT_LEN 74  // DS4 output report without its CRC
+
+static uint8_t samples[NUM_SAMPLES][MAX_LEN];
+
+static void fill_samples(void) {
+  srand(1234);
+  for (int i = 0; i < NUM_SAMPLES; i++) {
+    for (int j = 0; j < MAX_LEN; j++) {
+      samples[i][j] = rand() & 0xff;
+    }
+  }
+}
+
+static void bench(const char* name, uni_crc32_fn_t fn) {
+  uint32_t crc = 0;
+  bench_timer_t t;
+  bench_start(&t);
+  for (int r = 0; r < NUM_ROUNDS; r++) {
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+      crc ^= fn(0xffffffff, samples[i], OUTPUT_REPORT_LEN);
+      __asm volatile("" : : "r"(crc));
+    }
+  }
+  bench_report(&t, name, "report", (double)NUM_ROUNDS * NUM_SAMPLES);
+}
+
+int main(void) {
+  fill_samples();
+
+  // Unaligned starts and every length, so the word loop and the tail are both hit.
+  for (int i = 0; i < NUM_SAMPLES; i++) {
+    uint32_t seed = (uint32_t)rand() << 16 ^ (uint32_t)rand();
+    size_t offset = i % 4;
+    size_t len = i % (MAX_LEN - offset + 1);
+    uint32_t want = uni_crc32_le_bitwise(seed, samples[i] + offset, len);
+    uint32_t got = uni_crc32_le_table(seed, samples[i] + offset, len);
+    if (want != got) {
+      fprintf(stderr, "mismatch at sample %d: %08x != %08x\n", i, (unsigned)got, (unsigned)want);
+      return 1;
+    }
+  }
+  if (~uni_crc32_le(0xffffffff, (const uint8_t*)"123456789", 9) != 0xcbf43926) {
+    fprintf(stderr, "check value mismatch\n");
+    return 1;
+  }
+  printf("%d samples identical\n", NUM_SAMPLES);
+
+  bench("bitwise", uni_crc32_le_bitwise);
+  bench("table", uni_crc32_le_table);
+  return 0;
+}
@@ -0,0 +1,311 @@
+// Host-side benchmark for the DS4 input report decode (parser/uni_hid_parser_ds4.c).
+//
+// The reference is the previous decode: clear the controller before each
+// report, one test per button, mult_frac() per motion axis, with the
+// calibration computed from the feature report the way the parser used to.
+// It is compared with the shipping parser, driven through
+// uni_hid_parse_input_report() on a DS4 device whose calibration was loaded
+// with its feature report handler.
+//
+// For every calibration, every int16 motion sample goes through both, then
+// random reports. Calibration 0 is all zeroes and 1 has the largest divisors,
+// so the parser's fallback to default scaling and the widest scales are
+// covered. Then reports the cost of each per report.
+//
+// Needs btstack: built as bench_ds4_parse by the host build (host/).
+//   ./build-host/bench_ds4_parse
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <controller/uni_controller.h>
+#include <parser/uni_hid_parser.h>
+#include <parser/uni_hid_parser_ds4.h>
+#include <uni_common.h>
+#include <uni_hid_device.h>
+
+#include "bench_util.h"
+
+#define NUM_SAMPLES 4096
+#define NUM_ROUNDS 200
+#define NUM_CALIBRATIONS 64
+#define NUM_AXES 6  // gyro x, y, z, accel x, y, z
+
+#define DS4_VENDOR_ID 0x054c
+#define DS4_PRODUCT_ID 0x09cc
+
+// Same values as the parser.
+#define DS4_ACC_RES_PER_G 8192
+#define DS4_ACC_RANGE (4 * DS4_ACC_RES_PER_G)
+#define DS4_GYRO_RES_PER_DEG_S 1024
+#define DS4_GYRO_RANGE (2048 * DS4_GYRO_RES_PER_DEG_S)
+
+#define DS4_FEATURE_REPORT_CALIBRATION 0x02
+#define DS4_INPUT_REPORT_11_LEN 78
+#define DS4_INPUT_REPORT_11_PAYLOAD 3
+
+// Input report 0x11 from DS4_INPUT_REPORT_11_PAYLOAD, up to the status bytes.
+typedef struct __attribute((packed)) {
+  uint8_t x, y;
+  uint8_t rx, ry;
+  uint8_t buttons[3];
+  uint8_t brake;
+  uint8_t throttle;
+  uint16_t sensor_timestamp;
+  uint8_t sensor_temperature;
+  uint16_t gyro[3];
+  uint16_t accel[3];
+  uint8_t reserved[5];
+  uint8_t status[2];
+} ds4_report_t;
+
+// Feature report 0x02, Bluetooth layout.
+typedef struct __attribute((packed)) {
+  uint8_t report_id;
+  int16_t gyro_pitch_bias, gyro_yaw_bias, gyro_roll_bias;
+  int16_t gyro_pitch_plus, gyro_yaw_plus, gyro_roll_plus;
+  int16_t gyro_pitch_minus, gyro_yaw_minus, gyro_roll_minus;
+  int16_t gyro_speed_plus, gyro_speed_minus;
+  int16_t acc_x_plus, acc_x_minus;
+  int16_t acc_y_plus, acc_y_minus;
+  int16_t acc_z_plus, acc_z_minus;
+  uint8_t unk[2];
+} ds4_calibration_report_t;
+
+typedef struct {
+  ds4_calibration_report_t report;
+  int32_t numer[NUM_AXES];
+  int32_t denom[NUM_AXES];
+} calibration_t;
+
+static uint8_t reports[NUM_SAMPLES][DS4_INPUT_REPORT_11_LEN];
+static uint8_t sweep[DS4_INPUT_REPORT_11_LEN];
+static calibration_t calibrations[NUM_CALIBRATIONS];
+static uni_hid_device_t device;
+
+static int16_t rand16(void) {
+  return (int16_t)(rand() & 0xffff);
+}
+
+static const ds4_report_t* payload(const uint8_t* report) {
+  return (const ds4_report_t*)&report[DS4_INPUT_REPORT_11_PAYLOAD];
+}
+
+// The previous calibration report handling.
+static void reference_calibration(calibration_t* c) {
+  const ds4_calibration_report_t* r = &c->report;
+  int speed_2x = r->gyro_speed_plus + r->gyro_speed_minus;
+  const int16_t plus[3] = {r->gyro_pitch_plus, r->gyro_yaw_plus, r->gyro_roll_plus};
+  const int16_t minus[3] = {r->gyro_pitch_minus, r->gyro_yaw_minus, r->gyro_roll_minus};
+  const int16_t bias[3] = {r->gyro_pitch_bias, r->gyro_yaw_bias, r->gyro_roll_bias};
+  // As in the parser: pitch adds the bias to its minus term, yaw and roll subtract it.
+  const int minus_sign[3] = {1, -1, -1};
+  for (int i = 0; i < 3; i++) {
+    c->numer[i] = speed_2x * DS4_GYRO_RES_PER_DEG_S;
+    c->denom[i] = abs(plus[i] - bias[i]) + abs(minus[i] + minus_sign[i] * bias[i]);
+    if (c->denom[i] == 0) {
+      c->numer[i] = DS4_GYRO_RANGE;
+      c->denom[i] = INT16_MAX;
+    }
+  }
+  const int16_t acc_plus[3] = {r->acc_x_plus, r->acc_y_plus, r->acc_z_plus};
+  const int16_t acc_minus[3] = {r->acc_x_minus, r->acc_y_minus, r->acc_z_minus};
+  for (int i = 0; i < 3; i++) {
+    c->numer[i + 3] = 2 * DS4_ACC_RES_PER_G;
+    c->denom[i + 3] = acc_plus[i] - acc_minus[i];
+    if (c->denom[i + 3] == 0) {
+      c->numer[i + 3] = DS4_ACC_RANGE;
+      c->denom[i + 3] = INT16_MAX;
+    }
+  }
+}
+
+static void fill_samples(void) {
+  srand(1234);
+  for (int n = 0; n < NUM_CALIBRATIONS; n++) {
+    ds4_calibration_report_t* r = &calibrations[n].report;
+    if (n > 0) {
+      uint8_t* p = (uint8_t*)r;
+      for (size_t j = 0; j < sizeof(*r); j++) {
+        p[j] = rand() & 0xff;
+      }
+    }
+    // Largest divisors: both gyro terms at 65535, the widest accel range.
+    if (n == 1) {
+      r->gyro_pitch_plus = INT16_MAX;
+      r->gyro_pitch_bias = INT16_MIN;
+      r->gyro_pitch_minus = INT16_MAX;
+      r->acc_x_plus = INT16_MIN;
+      r->acc_x_minus = INT16_MAX;
+    }
+    r->report_id = DS4_FEATURE_REPORT_CALIBRATION;
+    reference_calibration(&calibrations[n]);
+  }
+
+  for (int i = 0; i < NUM_SAMPLES; i++) {
+    for (int j = 0; j < DS4_INPUT_REPORT_11_LEN; j++) {
+      reports[i][j] = rand() & 0xff;
+    }
+    reports[i][0] = 0x11;
+  }
+  memcpy(sweep, reports[0], sizeof(sweep));
+}
+
+static void load_calibration(const calibration_t* c) {
+  device.report_parser.parse_feature_report(&device, (const uint8_t*)&c->report, sizeof(c->report));
+}
+
+// The previous decode: uni_hid_parser_ds4_init_report(), then report 0x11.
+static void parse_reference(uni_controller_t* ctl, const uint8_t* report, const calibration_t* c) {
+  const ds4_report_t* r = payload(report);
+
+  memset(ctl, 0, sizeof(*ctl));
+  ctl->klass = UNI_CONTROLLER_CLASS_GAMEPAD;
+
+  ctl->gamepad.axis_x = (r->x - 127) * 4;
+  ctl->gamepad.axis_y = (r->y - 127) * 4;
+  ctl->gamepad.axis_rx = (r->rx - 127) * 4;
+  ctl->gamepad.axis_ry = (r->ry - 127) * 4;
+
+  uint8_t value = r->buttons[0] & 0xf;
+  if (value > 7)
+    value = 0xff;
+  ctl->gamepad.dpad = uni_hid_parser_hat_to_dpad(value);
+
+  if (r->buttons[0] & 0x10)
+    ctl->gamepad.buttons |= BUTTON_X;
+  if (r->buttons[0] & 0x20)
+    ctl->gamepad.buttons |= BUTTON_A;
+  if (r->buttons[0] & 0x40)
+    ctl->gamepad.buttons |= BUTTON_B;
+  if (r->buttons[0] & 0x80)
+    ctl->gamepad.buttons |= BUTTON_Y;
+  if (r->buttons[1] & 0x01)
+    ctl->gamepad.buttons |= BUTTON_SHOULDER_L;
+  if (r->buttons[1] & 0x02)
+    ctl->gamepad.buttons |= BUTTON_SHOULDER_R;
+  if (r->buttons[1] & 0x04)
+    ctl->gamepad.buttons |= BUTTON_TRIGGER_L;
+  if (r->buttons[1] & 0x08)
+    ctl->gamepad.buttons |= BUTTON_TRIGGER_R;
+  if (r->buttons[1] & 0x10)
+    ctl->gamepad.misc_buttons |= MISC_BUTTON_SELECT;
+  if (r->buttons[1] & 0x20)
+    ctl->gamepad.misc_buttons |= MISC_BUTTON_START;
+  if (r->buttons[1] & 0x40)
+    ctl->gamepad.buttons |= BUTTON_THUMB_L;
+  if (r->buttons[1] & 0x80)
+    ctl->gamepad.buttons |= BUTTON_THUMB_R;
+  if (r->buttons[2] & 0x01)
+    ctl->gamepad.misc_buttons |= MISC_BUTTON_SYSTEM;
+
+  ctl->gamepad.brake = r->brake * 4;
+  ctl->gamepad.throttle = r->throttle * 4;
+
+  for (int i = 0; i < 3; i++) {
+    ctl->gamepad.gyro[i] = mult_frac(c->numer[i], (int16_t)r->gyro[i], c->denom[i]);
+    ctl->gamepad.accel[i] = mult_frac(c->numer[i + 3], (int16_t)r->accel[i], c->denom[i + 3]);
+  }
+
+  ctl->battery = (r->status[0] & 0x0f) * 25 + 1;
+}
+
+static void parse_device(const uint8_t* report) {
+  uni_hid_parse_input_report(&device, report, DS4_INPUT_REPORT_11_LEN);
+}
+
+static int same_controller(const uni_controller_t* a, const uni_controller_t* b) {
+  const uni_gamepad_t* ga = &a->gamepad;
+  const uni_gamepad_t* gb = &b->gamepad;
+  return a->klass == b->klass && a->battery == b->battery && ga->dpad == gb->dpad && ga->axis_x == gb->axis_x &&
+         ga->axis_y == gb->axis_y && ga->axis_rx == gb->axis_rx && ga->axis_ry == gb->axis_ry &&
+         ga->brake == gb->brake && ga->throttle == gb->throttle && ga->buttons == gb->buttons &&
+         ga->misc_buttons == gb->misc_buttons && memcmp(ga->gyro, gb->gyro, sizeof(ga->gyro)) == 0 &&
+         memcmp(ga->accel, gb->accel, sizeof(ga->accel)) == 0;
+}
+
+static int check_report(const uint8_t* report, const calibration_t* c, int n, int i) {
+  uni_controller_t want;
+  parse_reference(&want, report, c);
+  parse_device(report);
+  if (!same_controller(&want, &device.controller)) {
+    fprintf(stderr, "mismatch: calibration %d, sample %d\n", n, i);
+    return 0;
+  }
+  return 1;
+}
+
+static int check(void) {
+  ds4_report_t* s = (ds4_report_t*)&sweep[DS4_INPUT_REPORT_11_PAYLOAD];
+  for (int n = 0; n < NUM_CALIBRATIONS; n++) {
+    const calibration_t* c = &calibrations[n];
+    load_calibration(c);
+    // The same sample on every axis: all of them see every int16 value.
+    for (int32_t x = INT16_MIN; x <= INT16_MAX; x++) {
+      for (int i = 0; i < 3; i++) {
+        s->gyro[i] = (uint16_t)x;
+        s->accel[i] = (uint16_t)x;
+      }
+      if (!check_report(sweep, c, n, x)) {
+        return 0;
+      }
+    }
+    for (int i = n; i < NUM_SAMPLES; i += NUM_CALIBRATIONS) {
+      if (!check_report(reports[i], c, n, i)) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+static void bench_reference(void) {
+  uni_controller_t ctl;
+  const calibration_t* c = &calibrations[2];
+  bench_timer_t t;
+  bench_start(&t);
+  for (int r = 0; r < NUM_ROUNDS; r++) {
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+      parse_reference(&ctl, reports[i], c);
+      __asm volatile("" : : "r"(&ctl) : "memory");
+    }
+  }
+  bench_report(&t, "reference", "report", (double)NUM_ROUNDS * NUM_SAMPLES);
+}
+
+static void bench_parser(void) {
+  load_calibration(&calibrations[2]);
+  bench_timer_t t;
+  bench_start(&t);
+  for (int r = 0; r < NUM_ROUNDS; r++) {
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+      parse_device(reports[i]);
+      __asm volatile("" : : "r"(&device.controller) : "memory");
+    }
+  }
+  bench_report(&t, "parser", "report", (double)NUM_ROUNDS * NUM_SAMPLES);
+}
+
+int main(void) {
+  // A DS4 as Bluepad32 sets it up from its VID/PID, without a Bluetooth link.
+  uni_hid_device_set_vendor_id(&device, DS4_VENDOR_ID);
+  uni_hid_device_set_product_id(&device, DS4_PRODUCT_ID);
+  uni_hid_device_guess_controller_type_from_pid_vid(&device);
+  if (device.controller_type != CONTROLLER_TYPE_PS4Controller) {
+    fprintf(stderr, "not detected as a DS4: 0x%02x\n", device.controller_type);
+    return 1;
+  }
+  // uni_hid_parser_ds4_setup() ends with this; the rest of it talks to the controller.
+  uni_hid_parser_ds4_init_report(&device);
+
+  fill_samples();
+  if (!check()) {
+    return 1;
+  }
+  printf("%d calibrations x %d samples + %d reports identical\n", NUM_CALIBRATIONS, 1 << 16, NUM_SAMPLES);
+
+  bench_reference();
+  bench_parser();
+  return 0;
+}
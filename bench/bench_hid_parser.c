@@ -0,0 +1,194 @@
+// Host-side benchmark for the compiled HID report map (uni_hid_report_map.c).
+//
+// For each descriptor, checks that the compiled map calls parse_usage with the
+// same globals, usages and values, in the same order, as the btstack HID
+// parser walk over random reports, then reports the cost of each per report.
+// Covers descriptors with and without report IDs, and reports shorter than
+// the descriptor. For those btstack reads the byte after the report, so the
+// samples are zero past the end, which is what the compiled map reads.
+//
+// Needs btstack: built as bench_hid_parser by the host build (host/).
+//   ./build-host/bench_hid_parser
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <parser/uni_hid_parser.h>
+#include <parser/uni_hid_report_map.h>
+
+#include "bench_util.h"
+
+#define NUM_SAMPLES 1024
+#define NUM_ROUNDS 200
+#define MAX_REPORT_LEN 80
+#define MAX_CALLS 256
+
+// Xbox One controller, firmware 4.8 (parser/uni_hid_parser_xboxone.c).
+static const uint8_t xbox_one_descriptor[] = {
+    0x05, 0x01, 0x09, 0x05, 0xa1, 0x01, 0x85, 0x01, 0x09, 0x01, 0xa1, 0x00, 0x09, 0x30, 0x09, 0x31, 0x15, 0x00, 0x27,
+    0xff, 0xff, 0x00, 0x00, 0x95, 0x02, 0x75, 0x10, 0x81, 0x02, 0xc0, 0x09, 0x01, 0xa1, 0x00, 0x09, 0x32, 0x09, 0x35,
+    0x15, 0x00, 0x27, 0xff, 0xff, 0x00, 0x00, 0x95, 0x02, 0x75, 0x10, 0x81, 0x02, 0xc0, 0x05, 0x02, 0x09, 0xc5, 0x15,
+    0x00, 0x26, 0xff, 0x03, 0x95, 0x01, 0x75, 0x0a, 0x81, 0x02, 0x15, 0x00, 0x25, 0x00, 0x75, 0x06, 0x95, 0x01, 0x81,
+    0x03, 0x05, 0x02, 0x09, 0xc4, 0x15, 0x00, 0x26, 0xff, 0x03, 0x95, 0x01, 0x75, 0x0a, 0x81, 0x02, 0x15, 0x00, 0x25,
+    0x00, 0x75, 0x06, 0x95, 0x01, 0x81, 0x03, 0x05, 0x01, 0x09, 0x39, 0x15, 0x01, 0x25, 0x08, 0x35, 0x00, 0x46, 0x3b,
+    0x01, 0x66, 0x14, 0x00, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42, 0x75, 0x04, 0x95, 0x01, 0x15, 0x00, 0x25, 0x00, 0x35,
+    0x00, 0x45, 0x00, 0x65, 0x00, 0x81, 0x03, 0x05, 0x09, 0x19, 0x01, 0x29, 0x0f, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01,
+    0x95, 0x0f, 0x81, 0x02, 0x15, 0x00, 0x25, 0x00, 0x75, 0x01, 0x95, 0x01, 0x81, 0x03, 0x05, 0x0c, 0x0a, 0x24, 0x02,
+    0x15, 0x00, 0x25, 0x01, 0x95, 0x01, 0x75, 0x01, 0x81, 0x02, 0x15, 0x00, 0x25, 0x00, 0x75, 0x07, 0x95, 0x01, 0x81,
+    0x03, 0x05, 0x0c, 0x09, 0x01, 0x85, 0x02, 0xa1, 0x01, 0x05, 0x0c, 0x0a, 0x23, 0x02, 0x15, 0x00, 0x25, 0x01, 0x95,
+    0x01, 0x75, 0x01, 0x81, 0x02, 0x15, 0x00, 0x25, 0x00, 0x75, 0x07, 0x95, 0x01, 0x81, 0x03, 0xc0, 0x05, 0x0f, 0x09,
+    0x21, 0x85, 0x03, 0xa1, 0x02, 0x09, 0x97, 0x15, 0x00, 0x25, 0x01, 0x75, 0x04, 0x95, 0x01, 0x91, 0x02, 0x15, 0x00,
+    0x25, 0x00, 0x75, 0x04, 0x95, 0x01, 0x91, 0x03, 0x09, 0x70, 0x15, 0x00, 0x25, 0x64, 0x75, 0x08, 0x95, 0x04, 0x91,
+    0x02, 0x09, 0x50, 0x66, 0x01, 0x10, 0x55, 0x0e, 0x15, 0x00, 0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x01, 0x91, 0x02,
+    0x09, 0xa7, 0x15, 0x00, 0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x01, 0x91, 0x02, 0x65, 0x00, 0x55, 0x00, 0x09, 0x7c,
+    0x15, 0x00, 0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x01, 0x91, 0x02, 0xc0, 0x05, 0x06, 0x09, 0x20, 0x85, 0x04, 0x15,
+    0x00, 0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x01, 0x81, 0x02, 0xc0,
+};
+
+// DualShock 4, input report 0x01 (usb_descriptors.c).
+static const uint8_t ds4_descriptor[] = {
+    0x05, 0x01, 0x09, 0x05, 0xa1, 0x01, 0x85, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x15, 0x00, 0x26,
+    0xff, 0x00, 0x75, 0x08, 0x95, 0x04, 0x81, 0x02, 0x09, 0x39, 0x15, 0x00, 0x25, 0x07, 0x35, 0x00, 0x46, 0x3b, 0x01,
+    0x65, 0x14, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42, 0x65, 0x00, 0x05, 0x09, 0x19, 0x01, 0x29, 0x0e, 0x15, 0x00, 0x25,
+    0x01, 0x75, 0x01, 0x95, 0x0e, 0x81, 0x02, 0x06, 0x00, 0xff, 0x09, 0x20, 0x75, 0x06, 0x95, 0x01, 0x81, 0x02, 0x05,
+    0x01, 0x09, 0x33, 0x09, 0x34, 0x15, 0x00, 0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x02, 0x81, 0x02, 0x06, 0x00, 0xff,
+    0x09, 0x21, 0x95, 0x36, 0x81, 0x02, 0xc0,
+};
+
+// Generic gamepad without report IDs: 4 axes, 12 buttons, hat switch.
+static const uint8_t generic_descriptor[] = {
+    0x05, 0x01, 0x09, 0x05, 0xa1, 0x01, 0x15, 0x00, 0x26, 0xff, 0x00, 0x75, 0x08, 0x95, 0x04, 0x09, 0x30, 0x09, 0x31,
+    0x09, 0x32, 0x09, 0x35, 0x81, 0x02, 0x05, 0x09, 0x19, 0x01, 0x29, 0x0c, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95,
+    0x0c, 0x81, 0x02, 0x75, 0x01, 0x95, 0x04, 0x81, 0x03, 0x05, 0x01, 0x09, 0x39, 0x15, 0x00, 0x25, 0x07, 0x35, 0x00,
+    0x46, 0x3b, 0x01, 0x65, 0x14, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42, 0x65, 0x00, 0x75, 0x04, 0x95, 0x01, 0x81, 0x03,
+    0xc0,
+};
+
+typedef struct {
+  const char* name;
+  const uint8_t* descriptor;
+  uint16_t descriptor_len;
+  uint8_t report_id;
+  uint16_t report_len;
+} descriptor_t;
+
+static const descriptor_t descriptors[] = {
+    {"xbox one", xbox_one_descriptor, sizeof(xbox_one_descriptor), 0x01, 17},
+    {"ds4", ds4_descriptor, sizeof(ds4_descriptor), 0x01, 64},
+    {"generic", generic_descriptor, sizeof(generic_descriptor), 0, 7},
+    // Reports cut short by the controller: the last fields are partly or fully missing.
+    {"xbox short", xbox_one_descriptor, sizeof(xbox_one_descriptor), 0x01, 9},
+    {"ds4 short", ds4_descriptor, sizeof(ds4_descriptor), 0x01, 6},
+    {"gen. short", generic_descriptor, sizeof(generic_descriptor), 0, 5},
+};
+
+typedef struct {
+  hid_globals_t globals;
+  uint16_t usage_page;
+  uint16_t usage;
+  int32_t value;
+} call_t;
+
+static call_t calls[MAX_CALLS];
+static int num_calls;
+static uint32_t sink;
+static uint8_t samples[NUM_SAMPLES][MAX_REPORT_LEN];
+
+static void record_usage(struct uni_hid_device_s* d, const hid_globals_t* globals, uint16_t usage_page,
+                         uint16_t usage, int32_t value) {
+  (void)d;
+  if (num_calls < MAX_CALLS) {
+    call_t* c = &calls[num_calls];
+    memset(c, 0, sizeof(*c));
+    c->globals.logical_minimum = globals->logical_minimum;
+    c->globals.logical_maximum = globals->logical_maximum;
+    c->globals.usage_page = globals->usage_page;
+    c->globals.report_size = globals->report_size;
+    c->globals.report_count = globals->report_count;
+    c->globals.report_id = globals->report_id;
+    c->usage_page = usage_page;
+    c->usage = usage;
+    c->value = value;
+  }
+  num_calls++;
+}
+
+// What a parser does at the least: look at every field.
+static void sum_usage(struct uni_hid_device_s* d, const hid_globals_t* globals, uint16_t usage_page, uint16_t usage,
+                      int32_t value) {
+  (void)d;
+  sink += globals->report_size + usage_page + usage + (uint32_t)value;
+}
+
+// report_id 0: the descriptor has none, the first byte is data.
+static void fill_samples(const descriptor_t* desc) {
+  for (int i = 0; i < NUM_SAMPLES; i++) {
+    memset(samples[i], 0, sizeof(samples[i]));
+    for (int j = 0; j < desc->report_len; j++) {
+      samples[i][j] = rand() & 0xff;
+    }
+    if (desc->report_id != 0) {
+      samples[i][0] = desc->report_id;
+    }
+  }
+}
+
+static void parse(const descriptor_t* desc, const uni_hid_report_map_t* map, const uint8_t* report,
+                  report_parse_usage_fn_t fn) {
+  if (map != NULL) {
+    uni_hid_report_map_parse(map, NULL, report, desc->report_len, fn);
+  } else {
+    uni_hid_parser_parse_usages(NULL, desc->descriptor, desc->descriptor_len, report, desc->report_len, fn);
+  }
+}
+
+static int check(const descriptor_t* desc, const uni_hid_report_map_t* map) {
+  static call_t want[MAX_CALLS];
+  for (int i = 0; i < NUM_SAMPLES; i++) {
+    num_calls = 0;
+    parse(desc, NULL, samples[i], record_usage);
+    int want_calls = num_calls;
+    memcpy(want, calls, sizeof(want));
+
+    num_calls = 0;
+    parse(desc, map, samples[i], record_usage);
+    if (num_calls != want_calls || num_calls > MAX_CALLS || memcmp(want, calls, num_calls * sizeof(call_t)) != 0) {
+      fprintf(stderr, "%s: mismatch at sample %d (%d vs %d fields)\n", desc->name, i, num_calls, want_calls);
+      return 1;
+    }
+  }
+  printf("%s: %d samples identical, %d fields per report\n", desc->name, NUM_SAMPLES, num_calls);
+  return 0;
+}
+
+static void bench(const char* name, const descriptor_t* desc, const uni_hid_report_map_t* map) {
+  bench_timer_t t;
+  bench_start(&t);
+  for (int r = 0; r < NUM_ROUNDS; r++) {
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+      parse(desc, map, samples[i], sum_usage);
+    }
+  }
+  bench_report(&t, name, "report", (double)NUM_ROUNDS * NUM_SAMPLES);
+}
+
+int main(void) {
+  static uni_hid_report_map_t map;
+
+  srand(1234);
+  for (size_t i = 0; i < sizeof(descriptors) / sizeof(descriptors[0]); i++) {
+    const descriptor_t* desc = &descriptors[i];
+    if (!uni_hid_report_map_compile(&map, desc->descriptor, desc->descriptor_len)) {
+      fprintf(stderr, "%s: descriptor not compiled\n", desc->name);
+      return 1;
+    }
+    fill_samples(desc);
+    if (check(desc, &map) != 0) {
+      return 1;
+    }
+    bench("btstack", desc, NULL);
+    bench("compiled", desc, &map);
+  }
+  return sink == 0xdeadbeef;
+}
@@ -0,0 +1,58 @@
+#ifndef BENCH_UTIL_H_
+#define BENCH_UTIL_H_
+
+// Timing shared by the host-side benchmarks: wall clock, plus the TSC on x86.
+//
+//   bench_timer_t t;
+//   bench_start(&t);
+//   ... n iterations ...
+//   bench_report(&t, "table", "report", n);
+//
+// prints "table  12.34 ns/report  45.67 cycles/report".
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+typedef struct {
+  uint64_t start_ns;
+  uint64_t start_tsc;
+} bench_timer_t;
+
+static inline uint64_t bench_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline void bench_start(bench_timer_t* t) {
+  t->start_ns = bench_now_ns();
+#if HAVE_TSC
+  t->start_tsc = __rdtsc();
+#else
+  t->start_tsc = 0;
+#endif
+}
+
+// n: iterations since bench_start(); unit: what one iteration is.
+static inline void bench_report(const bench_timer_t* t, const char* name, const char* unit, double n) {
+#if HAVE_TSC
+  uint64_t cycles = __rdtsc() - t->start_tsc;
+#endif
+  uint64_t elapsed_ns = bench_now_ns() - t->start_ns;
+
+#if HAVE_TSC
+  printf("%-12s %8.2f ns/%s %8.2f cycles/%s\n", name, elapsed_ns / n, unit, cycles / n, unit);
+#else
+  printf("%-12s %8.2f ns/%s\n", name, elapsed_ns / n, unit);
+#endif
+}
+
+#endif  // BENCH_UTIL_H_
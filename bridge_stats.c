@@ -0,0 +1,40 @@
+#include "bridge_stats.h"
+
+#include <string.h>
+
+#include <pico/time.h>
+
+#include "comm.h"
+#include "irq_plan.h"
+
+static uint16_t clamp_u16(uint32_t v) {
+  return v > UINT16_MAX ? UINT16_MAX : v;
+}
+
+void bridge_stats_fill(bridge_stats_report_t* report) {
+  memset(report, 0, sizeof(*report));
+  report->version = BRIDGE_STATS_VERSION;
+  report->bt_queue_depth = g_ds4_counters.bt_queue_depth;
+  report->bt_queue_max = g_ds4_counters.bt_queue_max;
+  report->cyw43_arch = irq_plan_get_arch();
+  report->uptime_ms = to_ms_since_boot(get_absolute_time());
+  report->frames_received = g_ds4_counters.bt_reports;
+  report->frames_forwarded = g_ds4_counters.usb_forwarded;
+  report->frames_overwritten = atomic_load_explicit(&g_ds4_shared.overwritten, memory_order_relaxed);
+  report->usb_reports = g_ds4_counters.usb_reports;
+  report->timeouts = g_ds4_counters.usb_timeouts;
+  for (int i = 0; i < LATENCY_SPAN_COUNT; i++) {
+    report->latency[i].p50_us = clamp_u16(latency_percentile_us(i, 500));
+    report->latency[i].p99_us = clamp_u16(latency_percentile_us(i, 990));
+  }
+}
+
+void bridge_stats_fill_link(bridge_link_stats_report_t* report) {
+  memset(report, 0, sizeof(*report));
+  report->version = BRIDGE_LINK_STATS_VERSION;
+  report->bt_out_sent = g_ds4_counters.bt_out_sent;
+  report->bt_out_merged = g_ds4_counters.bt_out_merged;
+  report->bt_out_dropped = g_ds4_counters.bt_out_dropped;
+  report->bt_out_deferred = g_ds4_counters.bt_out_deferred;
+  report->bt_crc_errors = g_ds4_counters.bt_crc_errors;
+}
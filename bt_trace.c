@@ -0,0 +1,155 @@
+#include "bt_trace.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#define BT_TRACE_MASK (BT_TRACE_BUF_SIZE - 1u)
+
+_Static_assert((BT_TRACE_BUF_SIZE & BT_TRACE_MASK) == 0, "BT_TRACE_BUF_SIZE must be a power of two");
+
+typedef struct {
+  uint8_t buf[BT_TRACE_BUF_SIZE];
+  // Free-running byte offsets into buf. Only touched by core1 while
+  // recording, and only by core0 while frozen.
+  uint32_t head;
+  uint32_t tail;
+  uint32_t records;
+  uint32_t dropped;
+
+  // Core0 read cursor into the stream (header + ring).
+  uint32_t read_pos;
+
+  // Hand-off between the cores: core1 raises `busy` around a write and then
+  // re-checks `state`; core0 sets `state` and then waits for `busy` to drop.
+  _Atomic uint32_t state;
+  _Atomic uint32_t busy;
+} bt_trace_t;
+
+static bt_trace_t g_bt_trace = {.state = BT_TRACE_STATE_RECORDING};
+
+static const bt_trace_header_t k_header = {.magic = BT_TRACE_MAGIC, .version = BT_TRACE_VERSION};
+
+static void ring_put(uint32_t pos, const void* src, uint32_t len) {
+  uint32_t off = pos & BT_TRACE_MASK;
+  uint32_t first = BT_TRACE_BUF_SIZE - off;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(&g_bt_trace.buf[off], src, first);
+  memcpy(g_bt_trace.buf, (const uint8_t*)src + first, len - first);
+}
+
+static void ring_get(uint32_t pos, void* dst, uint32_t len) {
+  uint32_t off = pos & BT_TRACE_MASK;
+  uint32_t first = BT_TRACE_BUF_SIZE - off;
+  if (first > len) {
+    first = len;
+  }
+  memcpy(dst, &g_bt_trace.buf[off], first);
+  memcpy((uint8_t*)dst + first, g_bt_trace.buf, len - first);
+}
+
+void bt_trace_record(const uint8_t* report, uint16_t len, uint32_t t_us) {
+  if (atomic_load_explicit(&g_bt_trace.state, memory_order_relaxed) != BT_TRACE_STATE_RECORDING) {
+    return;
+  }
+
+  atomic_store_explicit(&g_bt_trace.busy, 1, memory_order_seq_cst);
+  if (atomic_load_explicit(&g_bt_trace.state, memory_order_seq_cst) != BT_TRACE_STATE_RECORDING) {
+    atomic_store_explicit(&g_bt_trace.busy, 0, memory_order_release);
+    return;
+  }
+
+  uint32_t need = sizeof(bt_trace_record_t) + len;
+  if (len > BT_TRACE_MAX_REPORT_LEN) {
+    g_bt_trace.dropped++;
+  } else {
+    // Make room by dropping the oldest records.
+    while (g_bt_trace.head - g_bt_trace.tail + need > BT_TRACE_BUF_SIZE) {
+      bt_trace_record_t old;
+      ring_get(g_bt_trace.tail, &old, sizeof(old));
+      g_bt_trace.tail += sizeof(old) + old.len;
+      g_bt_trace.records--;
+      g_bt_trace.dropped++;
+    }
+
+    bt_trace_record_t rec = {.t_us = t_us, .len = len};
+    ring_put(g_bt_trace.head, &rec, sizeof(rec));
+    ring_put(g_bt_trace.head + sizeof(rec), report, len);
+    g_bt_trace.head += need;
+    g_bt_trace.records++;
+  }
+
+  atomic_store_explicit(&g_bt_trace.busy, 0, memory_order_release);
+}
+
+// Stops core1 from writing and waits for a write in progress to finish.
+static void bt_trace_freeze(void) {
+  atomic_store_explicit(&g_bt_trace.state, BT_TRACE_STATE_FROZEN, memory_order_seq_cst);
+  while (atomic_load_explicit(&g_bt_trace.busy, memory_order_seq_cst)) {
+  }
+}
+
+void bt_trace_command(bt_trace_cmd_t cmd) {
+  switch (cmd) {
+    case BT_TRACE_CMD_START:
+      bt_trace_freeze();
+      g_bt_trace.head = 0;
+      g_bt_trace.tail = 0;
+      g_bt_trace.records = 0;
+      g_bt_trace.dropped = 0;
+      g_bt_trace.read_pos = 0;
+      atomic_store_explicit(&g_bt_trace.state, BT_TRACE_STATE_RECORDING, memory_order_release);
+      break;
+    case BT_TRACE_CMD_FREEZE:
+      bt_trace_freeze();
+      g_bt_trace.read_pos = 0;
+      break;
+    case BT_TRACE_CMD_REWIND:
+      g_bt_trace.read_pos = 0;
+      break;
+    default:
+      break;
+  }
+}
+
+void bt_trace_get_status(bt_trace_status_t* status) {
+  uint32_t state = atomic_load_explicit(&g_bt_trace.state, memory_order_acquire);
+
+  memset(status, 0, sizeof(*status));
+  status->state = state;
+  status->version = BT_TRACE_VERSION;
+  // Only stable while frozen; a live snapshot is good enough for display.
+  status->records = g_bt_trace.records;
+  status->dropped = g_bt_trace.dropped;
+  status->stream_len = sizeof(k_header) + (g_bt_trace.head - g_bt_trace.tail);
+}
+
+uint16_t bt_trace_read(uint8_t* dst, uint16_t max_len) {
+  if (atomic_load_explicit(&g_bt_trace.state, memory_order_acquire) != BT_TRACE_STATE_FROZEN) {
+    return 0;
+  }
+
+  uint32_t stream_len = sizeof(k_header) + (g_bt_trace.head - g_bt_trace.tail);
+  uint16_t n = 0;
+  while (n < max_len && g_bt_trace.read_pos < stream_len) {
+    uint32_t pos = g_bt_trace.read_pos;
+    uint32_t chunk;
+    if (pos < sizeof(k_header)) {
+      chunk = sizeof(k_header) - pos;
+      if (chunk > (uint32_t)(max_len - n)) {
+        chunk = max_len - n;
+      }
+      memcpy(&dst[n], (const uint8_t*)&k_header + pos, chunk);
+    } else {
+      chunk = stream_len - pos;
+      if (chunk > (uint32_t)(max_len - n)) {
+        chunk = max_len - n;
+      }
+      ring_get(g_bt_trace.tail + pos - sizeof(k_header), &dst[n], chunk);
+    }
+    n += chunk;
+    g_bt_trace.read_pos += chunk;
+  }
+  return n;
+}
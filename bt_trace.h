@@ -0,0 +1,70 @@
+#ifndef BT_TRACE_H_
+#define BT_TRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Bluetooth input capture
+ * -----------------------
+ * Core1 records every HID input report it receives on the interrupt channel,
+ * with its arrival time, into a RAM ring. When the ring is full the oldest
+ * records are dropped, so it always holds the last BT_TRACE_BUF_SIZE bytes of
+ * input. Core0 freezes the ring and streams it out over USB (see
+ * usb_descriptors.c), and host/bridge_host replays it through the same parser
+ * and conversion code.
+ *
+ * Trace layout, little endian, no padding:
+ *   bt_trace_header_t                       once
+ *   { bt_trace_record_t; uint8_t report[len]; } ...
+ * `report` is the L2CAP interrupt payload without the 0xa1 transaction header,
+ * i.e. exactly what uni_hid_parse_input_report() is given.
+ */
+
+#define BT_TRACE_MAGIC 0x54345344u  // "DS4T"
+#define BT_TRACE_VERSION 1
+#define BT_TRACE_BUF_SIZE 32768  // must be a power of two
+#define BT_TRACE_MAX_REPORT_LEN 1024
+
+typedef struct __attribute__((packed)) {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t reserved[3];
+} bt_trace_header_t;
+
+typedef struct __attribute__((packed)) {
+  uint32_t t_us;  // time_us_32() at arrival
+  uint16_t len;
+} bt_trace_record_t;
+
+typedef enum {
+  BT_TRACE_STATE_RECORDING = 0,
+  BT_TRACE_STATE_FROZEN = 1,
+} bt_trace_state_t;
+
+// Commands accepted by bt_trace_command(). The host sends them as the first
+// byte of feature report BRIDGE_BT_TRACE_STATUS (usb_descriptors.c).
+typedef enum {
+  BT_TRACE_CMD_START = 1,   // clear the ring and record
+  BT_TRACE_CMD_FREEZE = 2,  // stop recording and rewind the read cursor
+  BT_TRACE_CMD_REWIND = 3,  // read the frozen trace again from the start
+} bt_trace_cmd_t;
+
+typedef struct __attribute__((packed)) {
+  uint8_t state;  // bt_trace_state_t
+  uint8_t version;
+  uint16_t reserved;
+  uint32_t records;     // records in the ring
+  uint32_t dropped;     // records pushed out or too long to store
+  uint32_t stream_len;  // bytes bt_trace_read() returns in total when frozen
+} bt_trace_status_t;
+
+// Core1: records one input report. Cheap no-op while frozen.
+void bt_trace_record(const uint8_t* report, uint16_t len, uint32_t t_us);
+
+// Core0: control and read-out. bt_trace_read() only returns data while frozen.
+void bt_trace_command(bt_trace_cmd_t cmd);
+void bt_trace_get_status(bt_trace_status_t* status);
+uint16_t bt_trace_read(uint8_t* dst, uint16_t max_len);
+
+#endif  // BT_TRACE_H_
@@ -1,5 +1,8 @@
 #include "comm.h"
 
-ds4_shared_t g_ds4_shared = {
-    .data.timestamp = 0,
-};
\ No newline at end of file
+ds4_shared_t g_ds4_shared = TRIPLE_BUFFER_INIT;
+
+volatile ds4_bridge_mode_t g_ds4_bridge_mode = DS4_BRIDGE_MODE;
+
+ds4_pickup_stats_t g_ds4_pickup_stats = {0};
+ds4_counters_t g_ds4_counters = {0};
\ No newline at end of file
@@ -6,16 +6,78 @@
 #include <hardware/sync.h>
 
 #include "dualshock4.h"
-#include "seqlock.h"
+#include "triple_buffer.h"
+
+typedef enum {
+  // Reports are decoded by Bluepad32 into uni_gamepad_t and re-encoded.
+  DS4_BRIDGE_MODE_NORMALIZED = 0,
+  // DS4 0x11 reports are forwarded byte for byte. Other controllers still
+  // use the normalized path.
+  DS4_BRIDGE_MODE_PASSTHROUGH = 1,
+  // Bluetooth stays off and core1 publishes generated frames instead
+  // (synth_input.h).
+  DS4_BRIDGE_MODE_SYNTHETIC = 2,
+} ds4_bridge_mode_t;
+
+#ifndef DS4_BRIDGE_MODE
+#define DS4_BRIDGE_MODE DS4_BRIDGE_MODE_NORMALIZED
+#endif
 
 typedef struct {
-  uint32_t timestamp;
-  uni_gamepad_t gamepad;
-  uint8_t battery;
+  uint32_t timestamp;     // publish time
+  uint32_t rx_timestamp;  // HCI arrival time of the report (latency.h)
+  ds4_bridge_mode_t mode;  // how the payload below is encoded
+  union {
+    struct {
+      uni_gamepad_t gamepad;
+      uint8_t battery;
+    };
+    uint8_t raw[sizeof(ds4_report_t)];  // 0x11 payload, already in USB layout
+  };
 } ds4_frame_t;
 
-SEQLOCK_DECL(ds4_shared_t, ds4_frame_t);
+TRIPLE_BUFFER_DECL(ds4_shared_t, ds4_frame_t);
 
 extern ds4_shared_t g_ds4_shared __attribute__((aligned(32)));
 
+// DS4_BRIDGE_MODE, fixed at build time; the host build sets it from the command
+// line before starting. Read by core1 for every report.
+extern volatile ds4_bridge_mode_t g_ds4_bridge_mode;
+
+// Handoff latency between core1 publishing a frame and core0 picking it up.
+// Only written by core0.
+typedef struct {
+  uint32_t frames;
+  uint32_t wait_us_last;
+  uint32_t wait_us_max;
+  uint64_t wait_us_total;
+} ds4_pickup_stats_t;
+
+extern ds4_pickup_stats_t g_ds4_pickup_stats;
+
+// Always-on operational counters, exported by bridge_stats.c. Each field is
+// only written by the core noted.
+typedef struct {
+  uint32_t bt_reports;      // core1: input reports received
+  uint8_t bt_queue_depth;   // core1: outgoing BT reports queued, sampled per input report
+  uint8_t bt_queue_max;     // core1
+  uint32_t bt_out_sent;      // core1: outgoing BT reports sent
+  uint32_t bt_out_merged;    // core1: outgoing BT reports replaced by a newer one while queued
+  uint32_t bt_out_dropped;   // core1: outgoing BT reports dropped, queue full
+  uint32_t bt_out_deferred;  // core1: times the output pacing held the queue back
+  uint32_t bt_crc_errors;   // core1: 0x11 input reports dropped for a bad CRC
+  uint32_t usb_forwarded;   // core0: frames sent to the host
+  uint32_t usb_reports;     // core0: all reports sent
+  uint32_t usb_timeouts;    // core0: switches to the neutral report (link_loss.h)
+} ds4_counters_t;
+
+extern ds4_counters_t g_ds4_counters;
+
+// Wake up core0 after a new frame has been published. Core0 sleeps in WFE
+// between USB events, so a SEV makes it pick up the frame right away instead
+// of waiting for the next poll.
+static inline void ds4_shared_notify(void) {
+  __sev();
+}
+
 #endif  // COMM_H_
\ No newline at end of file
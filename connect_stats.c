@@ -0,0 +1,87 @@
+#include "connect_stats.h"
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include <btstack.h>
+#include <pico/time.h>
+
+static connect_stats_report_t stats = {.version = CONNECT_STATS_VERSION};
+
+// Bumped by core1 after a connection's fields are written.
+static _Atomic uint32_t connect_gen;
+// Core1: time of the last disconnect, 0 before the first.
+static uint32_t disconnect_ms;
+// Core1: time the last baseband connection came up.
+static uint32_t acl_ms;
+// Core0: generation whose first forwarded frame has been recorded.
+static uint32_t forwarded_gen;
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+
+static uint32_t now_ms(void) {
+  return to_ms_since_boot(get_absolute_time());
+}
+
+void connect_stats_on_connected(connect_path_t path) {
+  stats.path = path;
+  stats.connections++;
+  stats.connect_ms = now_ms();
+  stats.ready_ms = 0;
+  stats.reconnect_ms = stats.connect_ms - disconnect_ms;
+  stats.connect_phase = stats.scan_phase;
+  atomic_fetch_add_explicit(&connect_gen, 1u, memory_order_release);
+}
+
+void connect_stats_on_disconnected(void) {
+  disconnect_ms = now_ms();
+}
+
+void connect_stats_on_scan(uint8_t phase, uint32_t page_scan_radio_ms, uint32_t inquiry_radio_ms) {
+  stats.scan_phase = phase;
+  stats.page_scan_radio_ms = page_scan_radio_ms;
+  stats.inquiry_radio_ms = inquiry_radio_ms;
+}
+
+static void connect_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packet, uint16_t size) {
+  (void)channel;
+  (void)size;
+
+  // Paging (ours or the controller's) succeeded: the baseband connection is
+  // up, before SDP and the L2CAP channels.
+  if (packet_type == HCI_EVENT_PACKET && hci_event_packet_get_type(packet) == HCI_EVENT_CONNECTION_COMPLETE &&
+      hci_event_connection_complete_get_status(packet) == ERROR_CODE_SUCCESS) {
+    acl_ms = now_ms();
+  }
+}
+
+void connect_stats_init(void) {
+  hci_event_callback_registration.callback = &connect_packet_handler;
+  hci_add_event_handler(&hci_event_callback_registration);
+}
+
+void connect_stats_on_ready(bool sdp_cached) {
+  stats.ready_ms = now_ms();
+  stats.sdp_cached = sdp_cached;
+  if (sdp_cached) {
+    stats.acl_to_ready_cached_ms = stats.ready_ms - acl_ms;
+  } else {
+    stats.acl_to_ready_sdp_ms = stats.ready_ms - acl_ms;
+  }
+}
+
+void connect_stats_on_forwarded(void) {
+  uint32_t gen = atomic_load_explicit(&connect_gen, memory_order_acquire);
+  if (gen == forwarded_gen) {
+    return;
+  }
+  forwarded_gen = gen;
+  stats.first_report_ms = now_ms();
+  if (stats.boot_to_first_report_ms == 0) {
+    stats.boot_to_first_report_ms = stats.first_report_ms;
+  }
+}
+
+void connect_stats_fill(connect_stats_report_t* report) {
+  memcpy(report, &stats, sizeof(*report));
+}
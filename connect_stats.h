@@ -0,0 +1,55 @@
+#ifndef CONNECT_STATS_H_
+#define CONNECT_STATS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Connection timeline, served as vendor feature report BRIDGE_CONNECT_STATS
+ * (usb_descriptors.c, tools/bridge_stats.py --connect). All times are ms
+ * since boot, 0 if the event has not happened yet. Fields are written by the
+ * core noted and read by core0.
+ */
+
+#define CONNECT_STATS_VERSION 3
+
+typedef enum {
+  CONNECT_PATH_NONE = 0,
+  CONNECT_PATH_INCOMING,  // the controller paged the bridge
+  CONNECT_PATH_DIRECTED,  // the bridge paged the last known controller
+  CONNECT_PATH_INQUIRY,   // found by inquiry
+} connect_path_t;
+
+typedef struct __attribute__((packed)) {
+  uint8_t version;                   // CONNECT_STATS_VERSION
+  uint8_t path;                      // connect_path_t of the last connection
+  uint16_t connections;              // since boot
+  uint32_t boot_to_first_report_ms;  // core0: first frame forwarded after boot
+  uint32_t connect_ms;               // core1: last connection established
+  uint32_t ready_ms;                 // core1: last controller ready
+  uint32_t first_report_ms;          // core0: first frame forwarded after that
+  uint32_t reconnect_ms;             // core1: last disconnect (or boot) to last connection
+  uint32_t page_scan_radio_ms;       // core1: estimated time the radio spent page scanning
+  uint32_t inquiry_radio_ms;         // core1: estimated time the radio spent in inquiry
+  uint8_t scan_phase;                // core1: scan_phase_t now
+  uint8_t connect_phase;             // core1: scan_phase_t the last connection came in
+  uint8_t sdp_cached;                // core1: the last controller skipped SDP (uni_bt_sdp_cache)
+  uint32_t acl_to_ready_sdp_ms;      // core1: ACL up to ready, last connection that queried SDP
+  uint32_t acl_to_ready_cached_ms;   // core1: ACL up to ready, last connection that used the cache
+} connect_stats_report_t;
+
+_Static_assert(sizeof(connect_stats_report_t) <= 63, "must fit in one feature report");
+
+// Core1.
+void connect_stats_init(void);
+void connect_stats_on_connected(connect_path_t path);
+void connect_stats_on_disconnected(void);
+// Scan phase and radio time totals, from scan_policy.c.
+void connect_stats_on_scan(uint8_t phase, uint32_t page_scan_radio_ms, uint32_t inquiry_radio_ms);
+void connect_stats_on_ready(bool sdp_cached);
+
+// Core0: called for every frame sent to the host.
+void connect_stats_on_forwarded(void);
+void connect_stats_fill(connect_stats_report_t* report);
+
+#endif  // CONNECT_STATS_H_
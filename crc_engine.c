@@ -0,0 +1,105 @@
+#include "crc_engine.h"
+
+#include <hardware/dma.h>
+#include <pico/time.h>
+#include <uni_utils.h>
+
+#include "debug.h"
+
+#define BENCH_LEN 74  // DS4 output report without its CRC
+#define BENCH_ROUNDS 256
+
+static int dma_channel = -1;
+static dma_channel_config dma_config;
+static uint32_t dma_sink;
+
+static uint32_t bit_reverse(uint32_t v) {
+  v = ((v >> 1) & 0x55555555u) | ((v & 0x55555555u) << 1);
+  v = ((v >> 2) & 0x33333333u) | ((v & 0x33333333u) << 2);
+  v = ((v >> 4) & 0x0f0f0f0fu) | ((v & 0x0f0f0f0fu) << 4);
+  return __builtin_bswap32(v);
+}
+
+// CRC-32R feeds each byte LSB first, like the reflected software CRC, but
+// keeps the accumulator unreflected: the seed goes in bit reversed and the
+// result comes out through OUT_REV.
+static uint32_t crc32_dma(uint32_t crc, const uint8_t* data, size_t len) {
+  if (len < CRC_ENGINE_DMA_MIN_LEN) {
+    return uni_crc32_le_table(crc, data, len);
+  }
+  dma_sniffer_set_data_accumulator(bit_reverse(crc));
+  // The buffer must be in memory before the channel reads it.
+  __compiler_memory_barrier();
+  dma_channel_configure(dma_channel, &dma_config, &dma_sink, data, len, true);
+  dma_channel_wait_for_finish_blocking(dma_channel);
+  return dma_sniffer_get_data_accumulator();
+}
+
+static bool crc32_dma_init(void) {
+  dma_channel = dma_claim_unused_channel(false);
+  if (dma_channel < 0) {
+    return false;
+  }
+  dma_config = dma_channel_get_default_config(dma_channel);
+  channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_8);
+  channel_config_set_read_increment(&dma_config, true);
+  channel_config_set_write_increment(&dma_config, false);
+  channel_config_set_sniff_enable(&dma_config, true);
+  dma_sniffer_enable(dma_channel, DMA_SNIFF_CTRL_CALC_VALUE_CRC32R, false);
+  dma_sniffer_set_output_reverse_enabled(true);
+  return true;
+}
+
+static void crc32_dma_release(void) {
+  dma_sniffer_disable();
+  dma_channel_unclaim(dma_channel);
+  dma_channel = -1;
+}
+
+#if IS_PICO_DEBUG
+static uint32_t bench_ns(uni_crc32_fn_t fn, const uint8_t* data) {
+  uint32_t crc = 0;
+  uint32_t start_us = time_us_32();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    crc ^= fn(0xffffffff, data, BENCH_LEN);
+  }
+  uint32_t elapsed_us = time_us_32() - start_us;
+  // Keeps the loop from being optimized out.
+  __asm volatile("" : : "r"(crc));
+  return elapsed_us * 1000u / BENCH_ROUNDS;
+}
+
+static void log_timings(const uint8_t* data, bool use_dma) {
+  PICO_INFO("crc32 per %d-byte report: bitwise %lu ns, table %lu ns\n", BENCH_LEN,
+            (unsigned long)bench_ns(uni_crc32_le_bitwise, data), (unsigned long)bench_ns(uni_crc32_le_table, data));
+  if (use_dma) {
+    PICO_INFO("crc32 per %d-byte report: dma %lu ns\n", BENCH_LEN, (unsigned long)bench_ns(crc32_dma, data));
+  }
+}
+#endif
+
+void crc_engine_init(void) {
+  uint8_t data[BENCH_LEN];
+  for (int i = 0; i < BENCH_LEN; i++) {
+    data[i] = (uint8_t)(i * 37 + 11);
+  }
+
+  bool use_dma = false;
+  if (CRC_ENGINE_USE_DMA && crc32_dma_init()) {
+    // Odd seeds and lengths so a wrong seed or output mapping shows up.
+    use_dma = crc32_dma(0xffffffff, data, BENCH_LEN) == uni_crc32_le_table(0xffffffff, data, BENCH_LEN) &&
+              crc32_dma(0x12345678, data, BENCH_LEN - 1) == uni_crc32_le_table(0x12345678, data, BENCH_LEN - 1);
+    if (!use_dma) {
+      PICO_ERROR("crc32: DMA sniffer self-test failed, using tables\n");
+      crc32_dma_release();
+    }
+  }
+
+#if IS_PICO_DEBUG
+  log_timings(data, use_dma);
+#endif
+  if (use_dma) {
+    uni_crc32_set_engine(crc32_dma);
+  }
+  PICO_INFO("crc32 engine: %s\n", use_dma ? "dma" : "table");
+}
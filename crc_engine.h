@@ -0,0 +1,44 @@
+#ifndef CRC_ENGINE_H_
+#define CRC_ENGINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * CRC32 engines
+ * -------------
+ * DS4 and DS5 Bluetooth reports end with a CRC32 (reflected IEEE 802.3,
+ * uni_crc32_le) over a 0xA2 (output) or 0xA1 (input) header byte and the
+ * report. Bluepad32 computes it for every output report, and the bridge can
+ * check it on every 0x11 input report (CRC_ENGINE_VERIFY_INPUT).
+ *
+ * Engines, selected once on core1 by crc_engine_init():
+ *
+ *   bitwise  one bit at a time, the original implementation. Reference only.
+ *   table    slice-by-4 tables in Bluepad32 (uni_utils.c). Default.
+ *   dma      the RP2350 DMA sniffer in CRC-32R mode on a dedicated channel,
+ *            reading the buffer into a dummy word. Used when
+ *            CRC_ENGINE_USE_DMA is set and a self-test against the tables
+ *            passes; buffers shorter than CRC_ENGINE_DMA_MIN_LEN still use
+ *            the tables, where the DMA setup costs more than it saves.
+ *
+ * crc_engine_init() also times each engine on an output report sized buffer
+ * and logs the results.
+ *
+ * Core1 only: the DMA sniffer is a single shared unit.
+ */
+
+#ifndef CRC_ENGINE_USE_DMA
+#define CRC_ENGINE_USE_DMA 1
+#endif
+#ifndef CRC_ENGINE_DMA_MIN_LEN
+#define CRC_ENGINE_DMA_MIN_LEN 32
+#endif
+#ifndef CRC_ENGINE_VERIFY_INPUT
+#define CRC_ENGINE_VERIFY_INPUT 1
+#endif
+
+// Core1, before bluetooth_init().
+void crc_engine_init(void);
+
+#endif  // CRC_ENGINE_H_
@@ -83,11 +83,67 @@ uint8_t dpad_mask_to_hat(uint8_t mask) {
   }
 }
 
+// Bytes 4-6 of ds4_report_t, built from whole bytes instead of bitfields.
+//   byte 4: dpad (0-3), west, south, east, north
+//   byte 5: l1, r1, l2, r2, select, start, l3, r3
+//   byte 6: home, touchpad, report_counter (2-7)
+#define DS4_BYTE_BUTTONS0 4
+#define DS4_BYTE_BUTTONS1 5
+#define DS4_BYTE_BUTTONS2 6
+#define DS4_BYTE_BATTERY 29
+
+// uni dpad mask -> hat value, same as dpad_mask_to_hat()
+static const uint8_t k_dpad_to_hat[16] = {
+    0x0F, 0x00, 0x04, 0x0F, 0x02, 0x01, 0x03, 0x0F, 0x06, 0x07, 0x05, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F,
+};
+
+// uni buttons A/B/X/Y (bits 0-3) -> upper nibble of byte 4
+static const uint8_t k_face_to_ds4[16] = {
+    0x00, 0x20, 0x40, 0x60, 0x10, 0x30, 0x50, 0x70, 0x80, 0xA0, 0xC0, 0xE0, 0x90, 0xB0, 0xD0, 0xF0,
+};
+
+// Everything convert_uni_to_ds4() does not overwrite is zero.
+static const ds4_report_t k_ds4_report_template = {0};
+
 void convert_uni_to_ds4(const uni_gamepad_t gamepad, const uint8_t battery, ds4_report_t* ds4) {
   if (ds4 == NULL) {
     return;
   }
 
+  static uint8_t report_counter = 0;
+  uint8_t* out = (uint8_t*)ds4;
+  uint16_t buttons = gamepad.buttons;
+  uint8_t misc_buttons = gamepad.misc_buttons;
+
+  memcpy(ds4, &k_ds4_report_template, sizeof(*ds4));
+
+  ds4->left_stick_x = (uint8_t)(gamepad.axis_x / 4 + 127);
+  ds4->left_stick_y = (uint8_t)(gamepad.axis_y / 4 + 127);
+  ds4->right_stick_x = (uint8_t)(gamepad.axis_rx / 4 + 127);
+  ds4->right_stick_y = (uint8_t)(gamepad.axis_ry / 4 + 127);
+
+  out[DS4_BYTE_BUTTONS0] = k_dpad_to_hat[gamepad.dpad & 0x0F] | k_face_to_ds4[buttons & 0x0F];
+  out[DS4_BYTE_BUTTONS1] = ((buttons >> 4) & 0x0F) | ((misc_buttons & 0x06) << 3) | (((buttons >> 8) & 0x03) << 6);
+  out[DS4_BYTE_BUTTONS2] = (misc_buttons & 0x01) | (uint8_t)((report_counter++ & 0x3F) << 2);
+
+  ds4->left_trigger = (uint8_t)(gamepad.brake / 4);
+  ds4->right_trigger = (uint8_t)(gamepad.throttle / 4);
+
+  ds4->gyro_x = (uint16_t)gamepad.gyro[0];
+  ds4->gyro_y = (uint16_t)gamepad.gyro[1];
+  ds4->gyro_z = (uint16_t)gamepad.gyro[2];
+  ds4->accel_x = (uint16_t)gamepad.accel[0];
+  ds4->accel_y = (uint16_t)gamepad.accel[1];
+  ds4->accel_z = (uint16_t)gamepad.accel[2];
+
+  out[DS4_BYTE_BATTERY] = (battery / 25) & 0x0F;
+}
+
+void convert_uni_to_ds4_reference(const uni_gamepad_t gamepad, const uint8_t battery, ds4_report_t* ds4) {
+  if (ds4 == NULL) {
+    return;
+  }
+
   // Report ID is removed in DS4 report format. It's injected by the tud_hid_report() function.
   // ds4->report_id = 0x01;
   ds4->left_stick_x = (uint8_t)(gamepad.axis_x / 4 + 127);
@@ -156,3 +212,18 @@ void convert_uni_to_ds4(const uni_gamepad_t gamepad, const uint8_t battery, ds4_
   memset(ds4->tpad_prev_touch2, 0, sizeof(ds4->tpad_prev_touch2));
   memset(ds4->unknown5, 0, sizeof(ds4->unknown5));
 }
+
+void convert_raw_to_ds4(const uint8_t* payload, ds4_report_t* ds4) {
+  if (ds4 == NULL) {
+    return;
+  }
+
+  memcpy(ds4, payload, sizeof(ds4_report_t));
+
+  // Bluetooth reports carry up to 4 touch reports, USB only 3. Drop the 4th
+  // one, whose first bytes overlap the USB padding.
+  if (ds4->touch_event > 3) {
+    ds4->touch_event = 3;
+  }
+  memset(&ds4->unknown5[9], 0, 3);
+}
@@ -0,0 +1,146 @@
+#include "frame_aggregator.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "dualshock4.h"
+
+// Raw frames are in ds4_report_t layout: the d-pad hat in the low nibble of
+// the first button byte, 14 buttons after it, then the report counter.
+#define RAW_BUTTONS (offsetof(ds4_report_t, right_stick_y) + 1)
+#define RAW_BUTTON_BYTES 3
+#define RAW_HAT_MASK 0x0f
+#define RAW_HAT_NEUTRAL 0x08
+#define RAW_TRIGGERS (RAW_BUTTONS + RAW_BUTTON_BYTES)  // left, right
+#define RAW_MOTION offsetof(ds4_report_t, gyro_x)      // gyro xyz, accel xyz
+#define MOTION_AXES 6
+
+static const uint8_t raw_button_mask[RAW_BUTTON_BYTES] = {0xf0, 0xff, 0x03};
+
+// What has been published since core0 last picked up a frame.
+static struct {
+  ds4_bridge_mode_t mode;
+  uint8_t dpad;  // last direction, normalized mask or raw hat
+  uint16_t buttons;
+  uint8_t misc_buttons;
+  uint8_t raw_buttons[RAW_BUTTON_BYTES];
+  int32_t triggers[2];
+  int32_t motion_sum[MOTION_AXES];
+  uint32_t frames;
+} acc;
+
+#if FRAME_AGGREGATOR_ENABLE
+
+#if FRAME_AGGREGATOR_AVERAGE_MOTION
+static void motion_get(const ds4_frame_t* frame, int32_t* motion) {
+  if (frame->mode == DS4_BRIDGE_MODE_PASSTHROUGH) {
+    for (int i = 0; i < MOTION_AXES; i++) {
+      int16_t v;
+      memcpy(&v, &frame->raw[RAW_MOTION + 2 * i], sizeof(v));
+      motion[i] = v;
+    }
+  } else {
+    memcpy(&motion[0], frame->gamepad.gyro, sizeof(frame->gamepad.gyro));
+    memcpy(&motion[3], frame->gamepad.accel, sizeof(frame->gamepad.accel));
+  }
+}
+
+static void motion_set(ds4_frame_t* frame, const int32_t* motion) {
+  if (frame->mode == DS4_BRIDGE_MODE_PASSTHROUGH) {
+    for (int i = 0; i < MOTION_AXES; i++) {
+      int16_t v = (int16_t)motion[i];
+      memcpy(&frame->raw[RAW_MOTION + 2 * i], &v, sizeof(v));
+    }
+  } else {
+    memcpy(frame->gamepad.gyro, &motion[0], sizeof(frame->gamepad.gyro));
+    memcpy(frame->gamepad.accel, &motion[3], sizeof(frame->gamepad.accel));
+  }
+}
+
+#endif
+
+static void acc_start(const ds4_frame_t* frame) {
+  acc.mode = frame->mode;
+  acc.frames = 1;
+  if (frame->mode == DS4_BRIDGE_MODE_PASSTHROUGH) {
+    acc.dpad = frame->raw[RAW_BUTTONS] & RAW_HAT_MASK;
+    for (int i = 0; i < RAW_BUTTON_BYTES; i++) {
+      acc.raw_buttons[i] = frame->raw[RAW_BUTTONS + i] & raw_button_mask[i];
+    }
+    acc.triggers[0] = frame->raw[RAW_TRIGGERS];
+    acc.triggers[1] = frame->raw[RAW_TRIGGERS + 1];
+  } else {
+    acc.dpad = frame->gamepad.dpad;
+    acc.buttons = frame->gamepad.buttons;
+    acc.misc_buttons = frame->gamepad.misc_buttons;
+    acc.triggers[0] = frame->gamepad.brake;
+    acc.triggers[1] = frame->gamepad.throttle;
+  }
+#if FRAME_AGGREGATOR_AVERAGE_MOTION
+  motion_get(frame, acc.motion_sum);
+#endif
+}
+
+static inline int32_t max_i32(int32_t a, int32_t b) {
+  return a > b ? a : b;
+}
+
+// Merges the frame into the accumulated state and writes the result back.
+static void acc_merge(ds4_frame_t* frame) {
+  acc.frames++;
+  if (frame->mode == DS4_BRIDGE_MODE_PASSTHROUGH) {
+    uint8_t* buttons = &frame->raw[RAW_BUTTONS];
+    uint8_t hat = buttons[0] & RAW_HAT_MASK;
+    if (hat != RAW_HAT_NEUTRAL) {
+      acc.dpad = hat;
+    }
+    for (int i = 0; i < RAW_BUTTON_BYTES; i++) {
+      acc.raw_buttons[i] |= buttons[i] & raw_button_mask[i];
+      buttons[i] |= acc.raw_buttons[i];
+    }
+    buttons[0] = (buttons[0] & ~RAW_HAT_MASK) | acc.dpad;
+
+    acc.triggers[0] = max_i32(acc.triggers[0], frame->raw[RAW_TRIGGERS]);
+    acc.triggers[1] = max_i32(acc.triggers[1], frame->raw[RAW_TRIGGERS + 1]);
+    frame->raw[RAW_TRIGGERS] = acc.triggers[0];
+    frame->raw[RAW_TRIGGERS + 1] = acc.triggers[1];
+  } else {
+    uni_gamepad_t* gp = &frame->gamepad;
+    if (gp->dpad) {
+      acc.dpad = gp->dpad;
+    }
+    gp->dpad = acc.dpad;
+    gp->buttons = acc.buttons |= gp->buttons;
+    gp->misc_buttons = acc.misc_buttons |= gp->misc_buttons;
+    gp->brake = acc.triggers[0] = max_i32(acc.triggers[0], gp->brake);
+    gp->throttle = acc.triggers[1] = max_i32(acc.triggers[1], gp->throttle);
+  }
+
+#if FRAME_AGGREGATOR_AVERAGE_MOTION
+  int32_t motion[MOTION_AXES];
+  motion_get(frame, motion);
+  for (int i = 0; i < MOTION_AXES; i++) {
+    acc.motion_sum[i] += motion[i];
+    motion[i] = acc.motion_sum[i] / (int32_t)acc.frames;
+  }
+  motion_set(frame, motion);
+#endif
+}
+
+#endif  // FRAME_AGGREGATOR_ENABLE
+
+void frame_aggregator_publish(ds4_frame_t* frame) {
+#if FRAME_AGGREGATOR_ENABLE
+  if (TRIPLE_BUFFER_PENDING(g_ds4_shared) && acc.mode == frame->mode) {
+    acc_merge(frame);
+  } else {
+    // Core0 has everything published so far.
+    acc_start(frame);
+  }
+#else
+  (void)frame;
+#endif
+  TRIPLE_BUFFER_PUBLISH(g_ds4_shared);
+  ds4_shared_notify();
+}
@@ -0,0 +1,331 @@
+// Host driver for the bridge pipeline.
+//
+// Feeds Bluetooth HID input reports through the same code the firmware runs
+// on core1 (Bluepad32 parser, remap, pico_bluetooth.c publish) and core0
+// (mailbox pickup, dualshock4.c convert, USB report), and reports the cost of
+// each stage in ns/frame.
+//
+// Input is either a trace captured on the device (see bt_trace.h and
+// tools/bt_trace.py) or synthesized DS4 0x11 reports. Traces are replayed at
+// maximum speed, or with their original timing with -r.
+//
+// Usage: bridge_host [-n frames] [-p] [-r] [trace]
+//   -n  number of frames to run (default 100000, or one pass of the trace)
+//   -p  passthrough mode (DS4_BRIDGE_MODE_PASSTHROUGH)
+//   -r  real-time replay, using the arrival times recorded in the trace
+
+#include <btstack.h>
+#include <btstack_run_loop_posix.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pico/time.h>
+#include <uni.h>
+#include <uni_hid_device.h>
+
+#include "bt_trace.h"
+#include "comm.h"
+#include "dualshock4.h"
+#include "latency.h"
+
+#define HOST_DEFAULT_FRAMES 100000
+#define HOST_INTERRUPT_CID 0x0041
+#define HOST_CONTROL_CID 0x0040
+#define HOST_DS4_VENDOR_ID 0x054c
+#define HOST_DS4_PRODUCT_ID 0x09cc
+
+struct uni_platform* get_my_platform(void);
+
+typedef enum {
+  STAGE_PARSE,    // raw hook or uni_hid_parse_input_report()
+  STAGE_PUBLISH,  // remap + on_controller_data() + mailbox publish
+  STAGE_CONVERT,  // mailbox read + convert_*_to_ds4()
+  STAGE_USB,      // tud_hid_report() stand-in
+  STAGE_COUNT,
+} stage_t;
+
+static const char* const k_stage_names[STAGE_COUNT] = {"parse", "publish", "convert", "usb"};
+
+typedef struct {
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint32_t count;
+} stage_stats_t;
+
+typedef struct {
+  uint8_t* data;
+  size_t len;
+  size_t pos;
+  uint32_t records;
+} trace_t;
+
+static stage_stats_t stats[STAGE_COUNT];
+
+// Stand-in for the TinyUSB endpoint buffer.
+static uint8_t usb_ep_buf[1 + sizeof(ds4_report_t)];
+static uint32_t usb_reports;
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void stage_add(stage_t stage, uint64_t elapsed_ns) {
+  stats[stage].total_ns += elapsed_ns;
+  stats[stage].count++;
+  if (elapsed_ns > stats[stage].max_ns) {
+    stats[stage].max_ns = elapsed_ns;
+  }
+}
+
+static bool tud_hid_report(uint8_t report_id, const void* report, uint16_t len) {
+  usb_ep_buf[0] = report_id;
+  memcpy(&usb_ep_buf[1], report, len);
+  __asm volatile("" : : "r"(usb_ep_buf) : "memory");
+  usb_reports++;
+  return true;
+}
+
+static bool trace_load(trace_t* trace, const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) {
+    perror(path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  trace->data = malloc(size > 0 ? size : 1);
+  trace->len = fread(trace->data, 1, size, f);
+  fclose(f);
+
+  bt_trace_header_t header;
+  if (trace->len < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, trace->data, sizeof(header));
+  if (header.magic != BT_TRACE_MAGIC || header.version != BT_TRACE_VERSION) {
+    fprintf(stderr, "%s: not a v%d bridge trace\n", path, BT_TRACE_VERSION);
+    return false;
+  }
+
+  // Count the complete records; a trailing partial record is ignored.
+  trace->pos = sizeof(header);
+  trace->records = 0;
+  size_t pos = sizeof(header);
+  while (pos + sizeof(bt_trace_record_t) <= trace->len) {
+    bt_trace_record_t rec;
+    memcpy(&rec, &trace->data[pos], sizeof(rec));
+    if (pos + sizeof(rec) + rec.len > trace->len) {
+      break;
+    }
+    pos += sizeof(rec) + rec.len;
+    trace->records++;
+  }
+  trace->len = pos;
+  return trace->records > 0;
+}
+
+// Returns the next report of the trace, wrapping around at the end.
+static const uint8_t* trace_next(trace_t* trace, uint16_t* len, uint32_t* t_us) {
+  if (trace->pos >= trace->len) {
+    trace->pos = sizeof(bt_trace_header_t);
+  }
+  bt_trace_record_t rec;
+  memcpy(&rec, &trace->data[trace->pos], sizeof(rec));
+  const uint8_t* report = &trace->data[trace->pos + sizeof(rec)];
+  trace->pos += sizeof(rec) + rec.len;
+  *len = rec.len;
+  *t_us = rec.t_us;
+  return report;
+}
+
+// Sleeps until `t_us` of trace time has passed since the first frame.
+static void replay_wait(uint32_t t_us, uint32_t t0_us, uint64_t start_ns) {
+  uint64_t due_ns = start_ns + (uint64_t)(t_us - t0_us) * 1000u;
+  uint64_t now = now_ns();
+  if (due_ns > now) {
+    struct timespec ts = {.tv_sec = (due_ns - now) / 1000000000u, .tv_nsec = (due_ns - now) % 1000000000u};
+    nanosleep(&ts, NULL);
+  }
+}
+
+// Builds a DS4 0x11 input report with moving sticks, triggers and buttons.
+static uint16_t synth_next(uint32_t seq, uint8_t* report) {
+  memset(report, 0, DS4_BT_REPORT_11_LEN);
+  report[0] = DS4_BT_REPORT_11_ID;
+  report[1] = 0xc0;
+
+  uint8_t* r = &report[DS4_BT_REPORT_11_PAYLOAD];
+  r[0] = 128 + (seq & 0x3f);
+  r[1] = 128 - (seq & 0x3f);
+  r[2] = seq;
+  r[3] = ~seq;
+  r[4] = ((seq >> 4) & 0x07) | (((seq >> 3) & 0x0f) << 4);
+  r[5] = seq >> 7;
+  r[6] = (seq >> 11) & 0x01;
+  r[7] = seq * 3;
+  r[8] = seq * 5;
+  for (int i = 9; i < 21; i++) {
+    r[i] = seq * i;
+  }
+  r[29] = 0x08;  // battery
+  return DS4_BT_REPORT_11_LEN;
+}
+
+static uni_hid_device_t* create_ds4_device(void) {
+  bd_addr_t addr = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+
+  uni_hid_device_t* d = uni_hid_device_create(addr);
+  if (d == NULL) {
+    return NULL;
+  }
+  uni_hid_device_set_name(d, "Wireless Controller");
+  uni_hid_device_set_vendor_id(d, HOST_DS4_VENDOR_ID);
+  uni_hid_device_set_product_id(d, HOST_DS4_PRODUCT_ID);
+  uni_hid_device_guess_controller_type_from_pid_vid(d);
+  d->conn.control_cid = HOST_CONTROL_CID;
+  d->conn.interrupt_cid = HOST_INTERRUPT_CID;
+  uni_hid_device_connect(d);
+
+  // The DS4 parser setup installs the default calibration and marks the
+  // device ready. The feature report requests it sends are dropped since
+  // there is no L2CAP channel.
+  uni_hid_device_set_ready(d);
+  return d;
+}
+
+// One trip through the pipeline, following uni_bt_bredr_on_l2cap_data_packet()
+// on core1 and usb_thread_run() on core0.
+static void run_frame(uni_hid_device_t* d, const uint8_t* input, uint16_t len) {
+  static ds4_report_t report;
+  uint64_t t0 = now_ns();
+
+  bool consumed = uni_get_platform()->on_raw_input_report(d, input, len);
+  if (!consumed) {
+    uni_hid_parse_input_report(d, input, len);
+  }
+  uint64_t t1 = now_ns();
+  stage_add(STAGE_PARSE, t1 - t0);
+
+  if (!consumed) {
+    uni_hid_device_process_controller(d);
+    t0 = now_ns();
+    stage_add(STAGE_PUBLISH, t0 - t1);
+    t1 = t0;
+  }
+
+  if (!TRIPLE_BUFFER_READ(g_ds4_shared)) {
+    return;
+  }
+  const ds4_frame_t* frame = TRIPLE_BUFFER_READ_SLOT(g_ds4_shared);
+  latency_on_pickup(frame->rx_timestamp, frame->timestamp, time_us_32());
+  if (frame->mode == DS4_BRIDGE_MODE_PASSTHROUGH) {
+    convert_raw_to_ds4(frame->raw, &report);
+  } else {
+    convert_uni_to_ds4(frame->gamepad, frame->battery, &report);
+  }
+  t0 = now_ns();
+  stage_add(STAGE_CONVERT, t0 - t1);
+
+  tud_hid_report(0x01, &report, sizeof(ds4_report_t));
+  latency_on_submit(time_us_32());
+  latency_on_complete(time_us_32());
+  stage_add(STAGE_USB, now_ns() - t0);
+}
+
+static void print_stats(uint32_t frames, uint64_t elapsed_ns) {
+  printf("frames: %u, usb reports: %u, elapsed: %.3f ms\n", frames, usb_reports, elapsed_ns / 1e6);
+  printf("throughput: %.0f frames/s (%.1f ns/frame)\n", frames * 1e9 / elapsed_ns, (double)elapsed_ns / frames);
+  printf("%-8s %10s %10s %10s\n", "stage", "frames", "avg ns", "max ns");
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    if (stats[i].count == 0) {
+      continue;
+    }
+    printf("%-8s %10u %10.1f %10llu\n", k_stage_names[i], stats[i].count,
+           (double)stats[i].total_ns / stats[i].count, (unsigned long long)stats[i].max_ns);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t frames = 0;
+  trace_t trace = {0};
+  bool use_trace = false;
+  bool real_time = false;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:pr")) != -1) {
+    switch (opt) {
+      case 'n':
+        frames = strtoul(optarg, NULL, 0);
+        break;
+      case 'p':
+        g_ds4_bridge_mode = DS4_BRIDGE_MODE_PASSTHROUGH;
+        break;
+      case 'r':
+        real_time = true;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n frames] [-p] [-r] [trace]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind < argc) {
+    if (!trace_load(&trace, argv[optind])) {
+      fprintf(stderr, "%s: empty or unreadable trace\n", argv[optind]);
+      return 1;
+    }
+    use_trace = true;
+  }
+  if (frames == 0) {
+    frames = use_trace ? trace.records : HOST_DEFAULT_FRAMES;
+  }
+
+  btstack_memory_init();
+  btstack_run_loop_init(btstack_run_loop_posix_get_instance());
+
+  // Same order as uni_init(), minus the HCI / BT setup.
+  uni_platform_set_custom(get_my_platform());
+  uni_property_init();
+  uni_platform_init(0, NULL);
+  uni_hid_device_setup();
+
+  uni_hid_device_t* d = create_ds4_device();
+  if (d == NULL || uni_bt_conn_get_state(&d->conn) != UNI_BT_CONN_STATE_DEVICE_READY) {
+    fprintf(stderr, "failed to set up DS4 device\n");
+    return 1;
+  }
+
+  static uint8_t synth_report[DS4_BT_REPORT_11_LEN];
+  uint32_t t0_us = 0;
+  uint64_t start_ns = now_ns();
+  for (uint32_t i = 0; i < frames; i++) {
+    const uint8_t* input = synth_report;
+    uint16_t len;
+    if (use_trace) {
+      uint32_t t_us;
+      input = trace_next(&trace, &len, &t_us);
+      if (i == 0) {
+        t0_us = t_us;
+      }
+      if (real_time) {
+        replay_wait(t_us, t0_us, start_ns);
+      }
+    } else {
+      len = synth_next(i, synth_report);
+    }
+    if (len < 1) {
+      continue;
+    }
+    run_frame(d, input, len);
+  }
+  uint64_t elapsed_ns = now_ns() - start_ns;
+
+  print_stats(frames, elapsed_ns);
+  free(trace.data);
+  return 0;
+}
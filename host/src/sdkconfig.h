@@ -0,0 +1,17 @@
+#ifndef CONFIG_SDKCONFIG_H_
+#define CONFIG_SDKCONFIG_H_
+
+// Host build: same Bluepad32 configuration as the firmware (../sdkconfig.h),
+// but with the POSIX target.
+#define CONFIG_BLUEPAD32_PLATFORM_CUSTOM
+#define CONFIG_TARGET_POSIX
+#define CONFIG_BLUEPAD32_LOG_LEVEL 0
+
+#define CONFIG_BLUEPAD32_MAX_DEVICES 1
+#define CONFIG_BLUEPAD32_MAX_ALLOWLIST 1
+#define CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES 4
+#define CONFIG_BLUEPAD32_GAP_SECURITY 1
+#define CONFIG_BLUEPAD32_ENABLE_BLE_BY_DEFAULT 1
+#define CONFIG_BLUEPAD32_DS4_BT_POLL_INTERVAL_MS 1
+
+#endif  // CONFIG_SDKCONFIG_H_
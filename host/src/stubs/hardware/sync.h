@@ -0,0 +1,15 @@
+#ifndef HOST_HARDWARE_SYNC_H_
+#define HOST_HARDWARE_SYNC_H_
+
+// Host stand-in for the Cortex-M event/barrier intrinsics. The host driver
+// runs both "cores" on one thread, so there is nobody to wake up.
+
+static inline void __sev(void) {}
+
+static inline void __wfe(void) {}
+
+static inline void __dmb(void) {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+#endif  // HOST_HARDWARE_SYNC_H_
@@ -0,0 +1,24 @@
+#ifndef HOST_PICO_CYW43_ARCH_H_
+#define HOST_PICO_CYW43_ARCH_H_
+
+// Host stand-in for the cyw43 driver. There is no radio; HCI traffic is
+// injected by the host driver instead.
+
+#include <stdbool.h>
+
+#include "pico/time.h"
+
+#define CYW43_WL_GPIO_LED_PIN 0
+
+static inline int cyw43_arch_init(void) {
+  return 0;
+}
+
+static inline void cyw43_arch_disable_ap_mode(void) {}
+
+static inline void cyw43_arch_gpio_put(unsigned int pin, bool value) {
+  (void)pin;
+  (void)value;
+}
+
+#endif  // HOST_PICO_CYW43_ARCH_H_
@@ -0,0 +1,41 @@
+#ifndef HOST_PICO_TIME_H_
+#define HOST_PICO_TIME_H_
+
+// Host stand-in for the Pico SDK time API, backed by CLOCK_MONOTONIC.
+
+#include <stdint.h>
+#include <time.h>
+
+typedef uint64_t absolute_time_t;
+
+static inline absolute_time_t get_absolute_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000u;
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t) {
+  return t;
+}
+
+static inline uint32_t to_ms_since_boot(absolute_time_t t) {
+  return (uint32_t)(t / 1000u);
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+  return (int64_t)(to - from);
+}
+
+static inline absolute_time_t make_timeout_time_us(uint64_t us) {
+  return get_absolute_time() + us;
+}
+
+static inline uint32_t time_us_32(void) {
+  return (uint32_t)get_absolute_time();
+}
+
+static inline uint64_t time_us_64(void) {
+  return get_absolute_time();
+}
+
+#endif  // HOST_PICO_TIME_H_
@@ -0,0 +1,94 @@
+#include "host_output.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include <btstack.h>
+#include <uni_output_queue.h>
+
+#include "debug.h"
+
+// Mailbox words: the values in the low bits, VALID once the host sent any.
+#define VALID (1u << 31)
+#define NONE 0u
+
+static _Atomic uint32_t posted_rumble;    // weak << 8 | strong
+static _Atomic uint32_t posted_lightbar;  // r << 16 | g << 8 | b
+
+// Core1 state.
+static uni_hid_device_t* device;
+static uint32_t applied_rumble;
+static uint32_t applied_lightbar;
+static uint32_t rumble_started_ms;
+static bool lightbar_turn;  // lightbar goes next if both changed
+static btstack_timer_source_t check_timer;
+
+void host_output_set_rumble(uint8_t weak, uint8_t strong) {
+  atomic_store_explicit(&posted_rumble, VALID | (uint32_t)weak << 8 | strong, memory_order_relaxed);
+}
+
+void host_output_set_lightbar(uint8_t r, uint8_t g, uint8_t b) {
+  atomic_store_explicit(&posted_lightbar, VALID | (uint32_t)r << 16 | (uint32_t)g << 8 | b, memory_order_relaxed);
+}
+
+// Sends at most one output report. Returns false if nothing had to be sent.
+static bool host_output_apply(void) {
+  const uni_report_parser_t* parser = &device->report_parser;
+  uint32_t now_ms = btstack_run_loop_get_time_ms();
+
+  uint32_t rumble = atomic_load_explicit(&posted_rumble, memory_order_relaxed);
+  bool rumble_on = (rumble & 0xffff) != 0;
+  bool renew = rumble_on && now_ms - rumble_started_ms >= HOST_OUTPUT_RUMBLE_MS / 2;
+  bool rumble_due = (rumble != applied_rumble || renew) && parser->play_dual_rumble != NULL;
+
+  uint32_t lightbar = atomic_load_explicit(&posted_lightbar, memory_order_relaxed);
+  bool lightbar_due = lightbar != applied_lightbar && parser->set_lightbar_color != NULL;
+
+  // Both changed: take turns, so a host updating the rumble on every check
+  // can't hold the lightbar back.
+  if (rumble_due && !(lightbar_due && lightbar_turn)) {
+    applied_rumble = rumble;
+    rumble_started_ms = now_ms;
+    lightbar_turn = true;
+    parser->play_dual_rumble(device, 0, rumble_on ? HOST_OUTPUT_RUMBLE_MS : 0, (rumble >> 8) & 0xff, rumble & 0xff);
+    return true;
+  }
+
+  if (lightbar_due) {
+    applied_lightbar = lightbar;
+    lightbar_turn = false;
+    parser->set_lightbar_color(device, (lightbar >> 16) & 0xff, (lightbar >> 8) & 0xff, lightbar & 0xff);
+    return true;
+  }
+  return false;
+}
+
+static void host_output_check(btstack_timer_source_t* ts) {
+  // A report still queued means the link is busy: let it drain first.
+  if (device != NULL && uni_output_queue_is_empty(&device->output_queue)) {
+    host_output_apply();
+  }
+  btstack_run_loop_set_timer(ts, HOST_OUTPUT_INTERVAL_MS);
+  btstack_run_loop_add_timer(ts);
+}
+
+void host_output_init(void) {
+  btstack_run_loop_set_timer_handler(&check_timer, &host_output_check);
+  btstack_run_loop_set_timer(&check_timer, HOST_OUTPUT_INTERVAL_MS);
+  btstack_run_loop_add_timer(&check_timer);
+}
+
+void host_output_on_ready(uni_hid_device_t* d) {
+  device = d;
+  // The parser set its own lightbar and no rumble: apply whatever the host
+  // asked for again.
+  applied_rumble = NONE;
+  applied_lightbar = NONE;
+  PICO_DEBUG("[BT] Forwarding host output reports to %s\n", bd_addr_to_str(d->conn.btaddr));
+}
+
+void host_output_on_disconnected(uni_hid_device_t* d) {
+  if (device == d) {
+    device = NULL;
+  }
+}
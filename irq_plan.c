@@ -0,0 +1,40 @@
+#include "irq_plan.h"
+
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <pico/cyw43_arch.h>
+#include <pico/stdlib.h>
+
+#include "debug.h"
+#include "latency.h"
+
+// Between the default and the highest priority, so that only USB on core0
+// would preempt it if they ever shared a core.
+#define RADIO_WAKE_IRQ_PRIORITY (PICO_HIGHEST_IRQ_PRIORITY + 0x40)
+
+// Runs before the cyw43 handler (CYW43_GPIO_IRQ_HANDLER_PRIORITY, 0x40),
+// which masks the level interrupt until the driver has been polled.
+static void radio_wake_irq_handler(void) {
+  if (gpio_get_irq_event_mask(CYW43_PIN_WL_HOST_WAKE) & GPIO_IRQ_LEVEL_HIGH) {
+    latency_on_radio_wake(time_us_32());
+  }
+}
+
+void irq_plan_core0(void) {
+  irq_set_priority(USBCTRL_IRQ, PICO_HIGHEST_IRQ_PRIORITY);
+}
+
+void irq_plan_core1(void) {
+  gpio_add_raw_irq_handler_with_order_priority(CYW43_PIN_WL_HOST_WAKE, radio_wake_irq_handler,
+                                               GPIO_RAW_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_priority(IO_IRQ_BANK0, RADIO_WAKE_IRQ_PRIORITY);
+  PICO_INFO("cyw43 arch: %s\n", irq_plan_get_arch() == IRQ_PLAN_ARCH_POLL ? "poll" : "background");
+}
+
+irq_plan_arch_t irq_plan_get_arch(void) {
+#if PICO_CYW43_ARCH_POLL
+  return IRQ_PLAN_ARCH_POLL;
+#else
+  return IRQ_PLAN_ARCH_BACKGROUND;
+#endif
+}
@@ -0,0 +1,171 @@
+#include "latency.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define LATENCY_PAGES_PER_SPAN (LATENCY_BUCKETS / LATENCY_PAGE_BUCKETS)
+
+_Static_assert(LATENCY_BUCKETS % LATENCY_PAGE_BUCKETS == 0, "pages must cover the histogram exactly");
+
+static latency_hist_t hists[LATENCY_SPAN_COUNT];
+
+// Last radio wake not yet followed by an ACL packet. Written from the GPIO IRQ.
+static volatile uint32_t wake_us;
+static volatile bool wake_pending;
+
+// Core1 state of the report being processed.
+static struct {
+  uint32_t hci_rx_us;
+  uint32_t l2cap_rx_us;
+  uint32_t parsed_us;
+  uint32_t reset_seen;
+} core1;
+
+// Core0 state of the report in flight.
+static struct {
+  uint32_t hci_rx_us;
+  uint32_t pickup_us;
+  uint32_t submit_us;
+  bool in_flight;
+  uint32_t page;
+} core0;
+
+// Core1 histograms are cleared by core1 itself when it sees a new generation.
+static _Atomic uint32_t reset_gen;
+
+static inline uint32_t bucket_for(uint32_t us) {
+  uint32_t b = us ? 32u - __builtin_clz(us) : 0u;
+  return b < LATENCY_BUCKETS ? b : LATENCY_BUCKETS - 1;
+}
+
+static inline void hist_add(latency_span_t span, uint32_t us) {
+  latency_hist_t* h = &hists[span];
+  h->samples++;
+  h->total_us += us;
+  if (us > h->max_us) {
+    h->max_us = us;
+  }
+  h->buckets[bucket_for(us)]++;
+}
+
+static void core1_maybe_reset(void) {
+  uint32_t gen = atomic_load_explicit(&reset_gen, memory_order_relaxed);
+  if (gen != core1.reset_seen) {
+    core1.reset_seen = gen;
+    memset(&hists[LATENCY_SPAN_HCI_TO_L2CAP], 0,
+           sizeof(latency_hist_t) * (LATENCY_SPAN_PARSED_TO_PUBLISH - LATENCY_SPAN_HCI_TO_L2CAP + 1));
+    memset(&hists[LATENCY_SPAN_WAKE_TO_HCI], 0, sizeof(latency_hist_t));
+  }
+}
+
+void latency_on_radio_wake(uint32_t now_us) {
+  wake_us = now_us;
+  wake_pending = true;
+}
+
+void latency_on_hci_acl_rx(uint32_t now_us) {
+  core1.hci_rx_us = now_us;
+  // Only the first packet of a wake: the rest were read in the same bus transfer.
+  if (wake_pending) {
+    wake_pending = false;
+    core1_maybe_reset();
+    hist_add(LATENCY_SPAN_WAKE_TO_HCI, now_us - wake_us);
+  }
+}
+
+void latency_on_l2cap_rx(uint32_t now_us) {
+  core1.l2cap_rx_us = now_us;
+  core1.parsed_us = now_us;
+}
+
+void latency_on_parsed(uint32_t now_us) {
+  core1.parsed_us = now_us;
+}
+
+uint32_t latency_on_publish(uint32_t now_us) {
+  core1_maybe_reset();
+  hist_add(LATENCY_SPAN_HCI_TO_L2CAP, core1.l2cap_rx_us - core1.hci_rx_us);
+  hist_add(LATENCY_SPAN_L2CAP_TO_PARSED, core1.parsed_us - core1.l2cap_rx_us);
+  hist_add(LATENCY_SPAN_PARSED_TO_PUBLISH, now_us - core1.parsed_us);
+  return core1.hci_rx_us;
+}
+
+void latency_on_pickup(uint32_t hci_rx_us, uint32_t publish_us, uint32_t now_us) {
+  hist_add(LATENCY_SPAN_PUBLISH_TO_PICKUP, now_us - publish_us);
+  core0.hci_rx_us = hci_rx_us;
+  core0.pickup_us = now_us;
+}
+
+void latency_on_submit(uint32_t now_us) {
+  hist_add(LATENCY_SPAN_PICKUP_TO_SUBMIT, now_us - core0.pickup_us);
+  core0.submit_us = now_us;
+  core0.in_flight = true;
+}
+
+void latency_on_complete(uint32_t now_us) {
+  // Neutral reports sent on timeout carry no frame and are not measured.
+  if (!core0.in_flight) {
+    return;
+  }
+  core0.in_flight = false;
+  hist_add(LATENCY_SPAN_SUBMIT_TO_COMPLETE, now_us - core0.submit_us);
+  hist_add(LATENCY_SPAN_HCI_TO_COMPLETE, now_us - core0.hci_rx_us);
+}
+
+const latency_hist_t* latency_get(latency_span_t span) {
+  return &hists[span];
+}
+
+uint32_t latency_percentile_us(latency_span_t span, uint32_t permille) {
+  const latency_hist_t* h = &hists[span];
+  uint32_t samples = h->samples;
+  if (samples == 0) {
+    return 0;
+  }
+
+  uint64_t target = ((uint64_t)samples * permille + 999) / 1000;
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < LATENCY_BUCKETS - 1; i++) {
+    seen += h->buckets[i];
+    if (seen >= target) {
+      return i ? (1u << i) - 1 : 0;
+    }
+  }
+  return h->max_us;
+}
+
+void latency_command(latency_cmd_t cmd) {
+  switch (cmd) {
+    case LATENCY_CMD_REWIND:
+      core0.page = 0;
+      break;
+    case LATENCY_CMD_RESET:
+      memset(&hists[LATENCY_SPAN_PUBLISH_TO_PICKUP], 0,
+             sizeof(latency_hist_t) * (LATENCY_SPAN_HCI_TO_COMPLETE - LATENCY_SPAN_PUBLISH_TO_PICKUP + 1));
+      atomic_fetch_add_explicit(&reset_gen, 1u, memory_order_relaxed);
+      core0.page = 0;
+      break;
+    default:
+      break;
+  }
+}
+
+void latency_read_page(latency_page_t* page) {
+  uint32_t span = core0.page / LATENCY_PAGES_PER_SPAN;
+  uint32_t first = (core0.page % LATENCY_PAGES_PER_SPAN) * LATENCY_PAGE_BUCKETS;
+  const latency_hist_t* h = &hists[span];
+
+  // Core1 spans may be updated while they are copied; each field is still
+  // read whole, which is good enough for a histogram.
+  page->span = span;
+  page->span_count = LATENCY_SPAN_COUNT;
+  page->first_bucket = first;
+  page->bucket_count = LATENCY_BUCKETS;
+  page->samples = h->samples;
+  page->max_us = h->max_us;
+  page->mean_us = h->samples ? (uint32_t)(h->total_us / h->samples) : 0;
+  memcpy(page->buckets, &h->buckets[first], sizeof(page->buckets));
+
+  core0.page = (core0.page + 1) % (LATENCY_SPAN_COUNT * LATENCY_PAGES_PER_SPAN);
+}
@@ -0,0 +1,86 @@
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdint.h>
+
+/*
+ * Per-stage latency tracepoints
+ * -----------------------------
+ * Each report is timestamped (time_us_32(), 1 us resolution) as it moves from
+ * the radio to the host:
+ *
+ *   radio wake -> HCI ACL rx -> L2CAP rx -> parsed -> published      (core1)
+ *                           -> picked up -> submitted -> completed  (core0)
+ *
+ * Every pair of consecutive stages, plus HCI rx -> completed end to end, feeds
+ * a log2 histogram in RAM. Radio wake is the cyw43 data-ready interrupt
+ * (irq_plan.h); its span shows how long the cyw43 arch takes to hand the
+ * packet to BTstack. Recording is a timer read, a CLZ and two
+ * increments, so it stays on in production builds. The histograms are read
+ * over USB (feature report BRIDGE_LATENCY, tools/latency.py).
+ *
+ * Core1 spans are only written by core1 and core0 spans only by core0.
+ */
+
+#define LATENCY_BUCKETS 16      // bucket i counts [2^(i-1), 2^i) us; 0 counts 0 us; last is open ended
+#define LATENCY_PAGE_BUCKETS 8  // buckets per feature report page
+
+typedef enum {
+  LATENCY_SPAN_HCI_TO_L2CAP = 0,
+  LATENCY_SPAN_L2CAP_TO_PARSED,
+  LATENCY_SPAN_PARSED_TO_PUBLISH,
+  LATENCY_SPAN_PUBLISH_TO_PICKUP,
+  LATENCY_SPAN_PICKUP_TO_SUBMIT,
+  LATENCY_SPAN_SUBMIT_TO_COMPLETE,
+  LATENCY_SPAN_HCI_TO_COMPLETE,
+  LATENCY_SPAN_WAKE_TO_HCI,  // last, so the spans above keep their numbers
+  LATENCY_SPAN_COUNT,
+} latency_span_t;
+
+typedef struct {
+  uint32_t samples;
+  uint32_t max_us;
+  uint64_t total_us;
+  uint32_t buckets[LATENCY_BUCKETS];
+} latency_hist_t;
+
+typedef enum {
+  LATENCY_CMD_REWIND = 0,  // next page read starts at span 0 again
+  LATENCY_CMD_RESET = 1,   // clear all histograms
+} latency_cmd_t;
+
+// One page of one span's histogram, as returned over USB.
+typedef struct __attribute__((packed)) {
+  uint8_t span;  // latency_span_t
+  uint8_t span_count;
+  uint8_t first_bucket;
+  uint8_t bucket_count;  // LATENCY_BUCKETS
+  uint32_t samples;
+  uint32_t max_us;
+  uint32_t mean_us;
+  uint32_t buckets[LATENCY_PAGE_BUCKETS];
+} latency_page_t;
+
+// Core1 tracepoints. latency_on_radio_wake() is called from the GPIO IRQ.
+void latency_on_radio_wake(uint32_t now_us);
+void latency_on_hci_acl_rx(uint32_t now_us);
+void latency_on_l2cap_rx(uint32_t now_us);
+void latency_on_parsed(uint32_t now_us);
+// Returns the HCI rx time of the report, to be carried with the frame.
+uint32_t latency_on_publish(uint32_t now_us);
+
+// Core0 tracepoints.
+void latency_on_pickup(uint32_t hci_rx_us, uint32_t publish_us, uint32_t now_us);
+void latency_on_submit(uint32_t now_us);
+void latency_on_complete(uint32_t now_us);
+
+// Core0: read-out.
+const latency_hist_t* latency_get(latency_span_t span);
+// Upper bound of the bucket holding the given quantile (in 1/1000), or 0 if
+// the span has no samples.
+uint32_t latency_percentile_us(latency_span_t span, uint32_t permille);
+void latency_command(latency_cmd_t cmd);
+// Fills the next page, cycling through all spans.
+void latency_read_page(latency_page_t* page);
+
+#endif  // LATENCY_H_
@@ -15,6 +15,7 @@
 #include "bt/uni_bt_allowlist.h"
 #include "bt/uni_bt_defines.h"
 #include "bt/uni_bt_sdp.h"
+#include "bt/uni_bt_sdp_cache.h"
 #include "platform/uni_platform.h"
 #include "uni_common.h"
 #include "uni_config.h"
@@ -29,6 +30,10 @@
 _Static_assert(INQUIRY_REMOTE_NAME_TIMEOUT_MS < HID_DEVICE_CONNECTION_TIMEOUT_MS, "Timeout too big");
 
 static bool bt_bredr_enabled = true;
+// Periodic inquiry timing set at runtime, in 1.28s units. 0: use the properties.
+static uint8_t inquiry_length_override;
+static uint8_t inquiry_min_period_override;
+static uint8_t inquiry_max_period_override;
 
 static void l2cap_create_control_connection(uni_hid_device_t* d) {
     uint8_t status;
@@ -57,20 +62,46 @@ static void inquiry_remote_name_timeout_callback(btstack_timer_source_t* ts) {
     loge("Failed to inquiry name for %s, using a fake one\n", bd_addr_to_str(d->conn.btaddr));
     // The device has no name. Just fake one
     uni_hid_device_set_name(d, "Controller without name");
+    // A cached device didn't wait for it.
+    if (d->sdp_cached || uni_bt_conn_get_state(&d->conn) >= UNI_BT_CONN_STATE_DEVICE_PENDING_READY)
+        return;
     uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_REMOTE_NAME_FETCHED);
     uni_bt_bredr_process_fsm(d);
 }
 
+static void request_remote_name(uni_hid_device_t* d) {
+    if (d->conn.clock_offset & UNI_BT_CLOCK_OFFSET_VALID)
+        gap_remote_name_request(d->conn.btaddr, d->conn.page_scan_repetition_mode, d->conn.clock_offset);
+    else
+        gap_remote_name_request(d->conn.btaddr, 0x02, 0x0000);
+
+    // Some devices might not respond to the name request
+    btstack_run_loop_set_timer(&d->inquiry_remote_name_timer, INQUIRY_REMOTE_NAME_TIMEOUT_MS);
+    btstack_run_loop_set_timer_context(&d->inquiry_remote_name_timer, d);
+    btstack_run_loop_set_timer_handler(&d->inquiry_remote_name_timer, &inquiry_remote_name_timeout_callback);
+    btstack_run_loop_add_timer(&d->inquiry_remote_name_timer);
+}
+
 void uni_bt_bredr_scan_start(void) {
     uint8_t status;
 
-    status = gap_inquiry_periodic_start(uni_bt_get_gap_inquiry_length(), uni_bt_get_gap_max_periodic_length(),
-                                        uni_bt_get_gap_min_periodic_length());
+    if (inquiry_length_override)
+        status = gap_inquiry_periodic_start(inquiry_length_override, inquiry_max_period_override,
+                                            inquiry_min_period_override);
+    else
+        status = gap_inquiry_periodic_start(uni_bt_get_gap_inquiry_length(), uni_bt_get_gap_max_periodic_length(),
+                                            uni_bt_get_gap_min_periodic_length());
     if (status)
         loge("Failed to start period inquiry, error=0x%02x\n", status);
     logi("BR/EDR scan -> 1\n");
 }
 
+void uni_bt_bredr_set_inquiry_timing(uint8_t length, uint8_t min_period, uint8_t max_period) {
+    inquiry_length_override = length;
+    inquiry_min_period_override = min_period;
+    inquiry_max_period_override = max_period;
+}
+
 void uni_bt_bredr_scan_stop(void) {
     uint8_t status;
 
@@ -124,6 +155,9 @@ void uni_bt_bredr_delete_bonded_keys(void) {
 
     logi(".\n");
     gap_link_key_iterator_done(&it);
+
+    // Cached SDP results are only useful for paired controllers.
+    uni_bt_sdp_cache_delete_all();
 }
 
 void uni_bt_bredr_list_bonded_keys(void) {
@@ -220,23 +254,31 @@ void uni_bt_bredr_process_fsm(uni_hid_device_t* d) {
     // Does it have a name?
     // The name is fetched at the very beginning, when we initiate the connection,
     // Or at the very end, when it is an incoming connection.
+    // A device in the SDP cache doesn't wait for it: the connection goes on, and the
+    // name is requested once the ACL link is up and lands whenever it lands.
     if (!uni_hid_device_has_name(d) &&
         ((state == UNI_BT_CONN_STATE_DEVICE_DISCOVERED) || state == UNI_BT_CONN_STATE_L2CAP_INTERRUPT_CONNECTED)) {
-        logi("uni_bt_process_fsm: requesting name\n");
-
-        if (d->conn.clock_offset & UNI_BT_CLOCK_OFFSET_VALID)
-            gap_remote_name_request(d->conn.btaddr, d->conn.page_scan_repetition_mode, d->conn.clock_offset);
-        else
-            gap_remote_name_request(d->conn.btaddr, 0x02, 0x0000);
-
-        uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_REMOTE_NAME_INQUIRED);
-
-        // Some devices might not respond to the name request
-        btstack_run_loop_set_timer(&d->inquiry_remote_name_timer, INQUIRY_REMOTE_NAME_TIMEOUT_MS);
-        btstack_run_loop_set_timer_context(&d->inquiry_remote_name_timer, d);
-        btstack_run_loop_set_timer_handler(&d->inquiry_remote_name_timer, &inquiry_remote_name_timeout_callback);
-        btstack_run_loop_add_timer(&d->inquiry_remote_name_timer);
-        return;
+        if (d->sdp_cached || uni_bt_sdp_cache_load(d)) {
+            // The SDP cache already knows what the name would be used for: don't wait for it.
+            if (state == UNI_BT_CONN_STATE_DEVICE_DISCOVERED) {
+                // Paging for the name and for the connection at the same time would collide.
+                // Connect now, the name is requested once the channels are open.
+                logi("uni_bt_process_fsm: cached, connecting before the name\n");
+                d->sdp_query_type = SDP_QUERY_BEFORE_CONNECT;
+                uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_SDP_HID_DESCRIPTOR_FETCHED);
+            } else {
+                logi("uni_bt_process_fsm: cached, requesting name in the background\n");
+                request_remote_name(d);
+                if (uni_hid_device_is_incoming(d))
+                    uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_SDP_HID_DESCRIPTOR_FETCHED);
+            }
+            state = uni_bt_conn_get_state(&d->conn);
+        } else {
+            logi("uni_bt_process_fsm: requesting name\n");
+            request_remote_name(d);
+            uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_REMOTE_NAME_INQUIRED);
+            return;
+        }
     }
 
     if (state == UNI_BT_CONN_STATE_REMOTE_NAME_FETCHED) {
@@ -430,6 +472,9 @@ void uni_bt_bredr_on_l2cap_channel_opened(uint16_t channel, const uint8_t* packe
         }
         logi("Removing key for device: %s.\n", bd_addr_to_str(address));
         gap_drop_link_key_for_bd_addr(device->conn.btaddr);
+        // The cached SDP results might be stale too. Query them again next time.
+        if (device->sdp_cached)
+            uni_bt_sdp_cache_delete(device->conn.btaddr);
         uni_hid_device_disconnect(device);
         uni_hid_device_delete(device);
         /* 'device' is destroyed, don't use */
@@ -526,6 +571,11 @@ void uni_bt_bredr_on_l2cap_data_packet(uint16_t channel, const uint8_t* packet,
         return;
     }
 
+    // Let the platform take the report as-is, skipping the parser.
+    if (uni_get_platform()->on_raw_input_report != NULL &&
+        uni_get_platform()->on_raw_input_report(d, &packet[1], size - 1))
+        return;
+
     // Skip the first byte, which is always 0xa1
     uni_hid_parse_input_report(d, &packet[1], size - 1);
     uni_hid_device_process_controller(d);
@@ -595,6 +645,39 @@ void uni_bt_bredr_on_gap_inquiry_result(uint16_t channel, const uint8_t* packet,
     }
 }
 
+bool uni_bt_bredr_connect_known_device(bd_addr_t addr,
+                                       uint32_t cod,
+                                       const char* name,
+                                       uint8_t page_scan_repetition_mode,
+                                       uint16_t clock_offset) {
+    uni_hid_device_t* d;
+
+    d = uni_hid_device_get_instance_for_address(addr);
+    if (d) {
+        logi("Device %s already known (state=0x%02x), not connecting\n", bd_addr_to_str(addr), d->conn.state);
+        return false;
+    }
+
+    d = uni_hid_device_create(addr);
+    if (d == NULL) {
+        loge("\nError: cannot create device, no more available slots\n");
+        return false;
+    }
+
+    logi("Connecting to known device %s\n", bd_addr_to_str(addr));
+    uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_DEVICE_DISCOVERED);
+    uni_hid_device_set_cod(d, cod);
+    d->conn.page_scan_repetition_mode = page_scan_repetition_mode;
+    d->conn.clock_offset = clock_offset;
+
+    if (name && name[0] != 0) {
+        uni_hid_device_set_name(d, name);
+        uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_REMOTE_NAME_FETCHED);
+    }
+    uni_bt_bredr_process_fsm(d);
+    return true;
+}
+
 void uni_bt_bredr_on_hci_connection_request(uint16_t channel, const uint8_t* packet, uint16_t size) {
     bd_addr_t event_addr;
     uint32_t cod;
@@ -743,7 +826,8 @@ void uni_bt_bredr_on_hci_remote_name_request_complete(uint16_t channel, const ui
         // It could happen that the device is already connected, but the NAME_REQUEST
         // has just finished. So, do not update the state:
         // See: https://gitlab.com/ricardoquesada/bluepad32/-/issues/21
-        if (uni_bt_conn_get_state(&d->conn) < UNI_BT_CONN_STATE_DEVICE_PENDING_READY) {
+        // And a cached device (uni_bt_sdp_cache.h) asked for the name without waiting for it.
+        if (!d->sdp_cached && uni_bt_conn_get_state(&d->conn) < UNI_BT_CONN_STATE_DEVICE_PENDING_READY) {
             // Only update state if the device is not already ready.
             uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_REMOTE_NAME_FETCHED);
             uni_bt_bredr_process_fsm(d);
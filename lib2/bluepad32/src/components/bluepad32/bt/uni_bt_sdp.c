@@ -54,6 +54,7 @@
 
 #include "bt/uni_bt.h"
 #include "bt/uni_bt_bredr.h"
+#include "bt/uni_bt_sdp_cache.h"
 #include "uni_common.h"
 #include "uni_config.h"
 #include "uni_log.h"
@@ -218,6 +219,13 @@ static void sdp_query_timeout(btstack_timer_source_t* ts) {
 
 void uni_bt_sdp_query_start(uni_hid_device_t* d) {
     logi("-----------> sdp_query_start()\n");
+    // A controller seen before doesn't need the round trips.
+    if (uni_bt_sdp_cache_load(d)) {
+        uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_SDP_HID_DESCRIPTOR_FETCHED);
+        uni_bt_bredr_process_fsm(d);
+        return;
+    }
+
     // Needed for the SDP query since it only supports one SDP query at the time.
     if (sdp_device != NULL) {
         logi("Another SDP query is in progress (%s), disconnecting...\n", bd_addr_to_str(sdp_device->conn.btaddr));
@@ -241,6 +249,7 @@ void uni_bt_sdp_query_end(uni_hid_device_t* d) {
     uni_bt_conn_set_state(&d->conn, UNI_BT_CONN_STATE_SDP_HID_DESCRIPTOR_FETCHED);
     sdp_device = NULL;
     btstack_run_loop_remove_timer(&sdp_query_timer);
+    uni_bt_sdp_cache_store(d);
     uni_bt_bredr_process_fsm(d);
 }
 
@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "bt/uni_bt_sdp_cache.h"
+
+#include <btstack.h>
+#include <btstack_tlv.h>
+#include <string.h>
+
+#include "sdkconfig.h"
+
+#include "controller/uni_controller_type.h"
+#include "uni_common.h"
+#include "uni_log.h"
+
+// Same default as Kconfig, for sdkconfig.h files that predate the cache.
+#ifndef CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES
+#define CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES 4
+#endif
+
+// Prevent possible clashes with the 'B' 'P' '3' properties and user tags.
+static const char tag_0 = 'B';
+static const char tag_1 = 'P';
+static const char tag_2 = 'S';
+
+typedef struct __attribute__((packed)) {
+    bd_addr_t addr;
+    uint16_t vendor_id;
+    uint16_t product_id;
+    uint16_t controller_type;
+    uint16_t hid_descriptor_len;
+    // Bumped on every store, to evict the least recently stored entry.
+    uint32_t seq;
+} sdp_cache_header_t;
+
+typedef struct __attribute__((packed)) {
+    sdp_cache_header_t header;
+    uint8_t hid_descriptor[HID_MAX_DESCRIPTOR_LEN];
+} sdp_cache_entry_t;
+
+// Shared, to keep it out of the BTstack stack.
+static sdp_cache_entry_t entry;
+
+static uint32_t get_tag_for_index(int index) {
+    return (tag_0 << 24) | (tag_1 << 16) | (tag_2 << 8) | index;
+}
+
+static bool get_tlv(const btstack_tlv_t** impl, void** context) {
+    btstack_tlv_get_instance(impl, context);
+    return *impl != NULL;
+}
+
+// Reads the entry at index into "entry". Returns false if it is empty or invalid.
+static bool read_entry(const btstack_tlv_t* impl, void* context, int index) {
+    int len = impl->get_tag(context, get_tag_for_index(index), (uint8_t*)&entry, sizeof(entry));
+    if (len < (int)sizeof(entry.header))
+        return false;
+    if (len != (int)sizeof(entry.header) + entry.header.hid_descriptor_len) {
+        loge("SDP cache: invalid entry %d, len=%d\n", index, len);
+        return false;
+    }
+    return true;
+}
+
+// Returns the index holding the address, or -1.
+static int find_entry(const btstack_tlv_t* impl, void* context, const bd_addr_t addr) {
+    for (int i = 0; i < CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES; i++) {
+        if (read_entry(impl, context, i) && bd_addr_cmp(entry.header.addr, addr) == 0)
+            return i;
+    }
+    return -1;
+}
+
+bool uni_bt_sdp_cache_load(uni_hid_device_t* d) {
+    const btstack_tlv_t* impl;
+    void* context;
+
+    if (CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES == 0 || !get_tlv(&impl, &context))
+        return false;
+
+    int idx = find_entry(impl, context, d->conn.btaddr);
+    if (idx < 0)
+        return false;
+
+    if (!uni_hid_device_has_name(d)) {
+        // The name is fetched in the background on a hit. Some fallbacks of the
+        // type guess need it, so only a VID/PID found in the DB can go without it.
+        uni_controller_type_t type = uni_guess_controller_type(entry.header.vendor_id, entry.header.product_id);
+        if (type == CONTROLLER_TYPE_Unknown || type == CONTROLLER_TYPE_UnknownNonSteamController ||
+            type == CONTROLLER_TYPE_UnknownSteamController)
+            return false;
+    }
+
+    bool had_type = uni_hid_device_has_controller_type(d);
+    uni_hid_device_set_vendor_id(d, entry.header.vendor_id);
+    uni_hid_device_set_product_id(d, entry.header.product_id);
+    uni_hid_device_guess_controller_type_from_pid_vid(d);
+
+    if (d->controller_type != entry.header.controller_type) {
+        // Could happen if the name or COD changed. Undo the cached values so the
+        // SDP query starts from scratch and guesses the type again.
+        loge("SDP cache: %s was type 0x%02x, now 0x%02x. Dropping entry\n", bd_addr_to_str(d->conn.btaddr),
+             entry.header.controller_type, d->controller_type);
+        impl->delete_tag(context, get_tag_for_index(idx));
+        uni_hid_device_set_vendor_id(d, 0);
+        uni_hid_device_set_product_id(d, 0);
+        if (!had_type)
+            uni_hid_device_clear_controller_type(d);
+        return false;
+    }
+
+    if (uni_hid_device_does_require_hid_descriptor(d)) {
+        if (entry.header.hid_descriptor_len == 0) {
+            // Type is already set, so the SDP query won't change it. Just fetch the descriptor.
+            logi("SDP cache: %s has no HID descriptor cached\n", bd_addr_to_str(d->conn.btaddr));
+            return false;
+        }
+        uni_hid_device_set_hid_descriptor(d, entry.hid_descriptor, entry.header.hid_descriptor_len);
+    }
+
+    logi("SDP cache: %s -> VID=0x%04x, PID=0x%04x, HID descriptor len=%d\n", bd_addr_to_str(d->conn.btaddr),
+         entry.header.vendor_id, entry.header.product_id, entry.header.hid_descriptor_len);
+    d->sdp_cached = true;
+    return true;
+}
+
+void uni_bt_sdp_cache_store(const uni_hid_device_t* d) {
+    const btstack_tlv_t* impl;
+    void* context;
+
+    if (CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES == 0 || !get_tlv(&impl, &context))
+        return;
+
+    uint16_t descriptor_len = uni_hid_device_has_hid_descriptor(d) ? d->hid_descriptor_len : 0;
+
+    // Same address: overwrite it. Otherwise an empty slot, or the oldest one.
+    int idx = -1;
+    int empty_idx = -1;
+    int oldest_idx = 0;
+    uint32_t oldest_seq = UINT32_MAX;
+    uint32_t max_seq = 0;
+    for (int i = 0; i < CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES; i++) {
+        if (!read_entry(impl, context, i)) {
+            if (empty_idx < 0)
+                empty_idx = i;
+            continue;
+        }
+        max_seq = btstack_max(max_seq, entry.header.seq);
+        if (bd_addr_cmp(entry.header.addr, d->conn.btaddr) == 0) {
+            idx = i;
+            // Flash is only written when something changed.
+            if (entry.header.vendor_id == d->vendor_id && entry.header.product_id == d->product_id &&
+                entry.header.controller_type == d->controller_type &&
+                entry.header.hid_descriptor_len == descriptor_len &&
+                memcmp(entry.hid_descriptor, d->hid_descriptor, descriptor_len) == 0)
+                return;
+        } else if (entry.header.seq < oldest_seq) {
+            oldest_seq = entry.header.seq;
+            oldest_idx = i;
+        }
+    }
+    if (idx < 0)
+        idx = empty_idx >= 0 ? empty_idx : oldest_idx;
+
+    memset(&entry.header, 0, sizeof(entry.header));
+    bd_addr_copy(entry.header.addr, d->conn.btaddr);
+    entry.header.vendor_id = d->vendor_id;
+    entry.header.product_id = d->product_id;
+    entry.header.controller_type = d->controller_type;
+    entry.header.hid_descriptor_len = descriptor_len;
+    entry.header.seq = max_seq + 1;
+    memcpy(entry.hid_descriptor, d->hid_descriptor, descriptor_len);
+
+    if (impl->store_tag(context, get_tag_for_index(idx), (const uint8_t*)&entry,
+                        sizeof(entry.header) + descriptor_len)) {
+        loge("SDP cache: failed to store %s\n", bd_addr_to_str(d->conn.btaddr));
+        return;
+    }
+    logi("SDP cache: stored %s in entry %d\n", bd_addr_to_str(d->conn.btaddr), idx);
+}
+
+void uni_bt_sdp_cache_delete(const bd_addr_t addr) {
+    const btstack_tlv_t* impl;
+    void* context;
+
+    if (CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES == 0 || !get_tlv(&impl, &context))
+        return;
+
+    int idx = find_entry(impl, context, addr);
+    if (idx >= 0)
+        impl->delete_tag(context, get_tag_for_index(idx));
+}
+
+void uni_bt_sdp_cache_delete_all(void) {
+    const btstack_tlv_t* impl;
+    void* context;
+
+    if (CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES == 0 || !get_tlv(&impl, &context))
+        return;
+
+    for (int i = 0; i < CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES; i++)
+        impl->delete_tag(context, get_tag_for_index(i));
+}
@@ -0,0 +1,55 @@
+#ifndef BRIDGE_STATS_H_
+#define BRIDGE_STATS_H_
+
+#include <stdint.h>
+
+#include "latency.h"
+
+/*
+ * Live bridge statistics, served as vendor feature reports BRIDGE_STATS and
+ * BRIDGE_LINK_STATS (usb_descriptors.c) so they can be polled without a UART
+ * or a debug build. Counters are free running and 32 bits wide; readers
+ * compute rates from deltas.
+ */
+
+#define BRIDGE_STATS_VERSION 4
+#define BRIDGE_LINK_STATS_VERSION 1
+
+typedef struct __attribute__((packed)) {
+  uint16_t p50_us;  // upper bound of the log2 bucket holding the median
+  uint16_t p99_us;
+} bridge_stats_latency_t;
+
+typedef struct __attribute__((packed)) {
+  uint8_t version;  // BRIDGE_STATS_VERSION
+  uint8_t bt_queue_depth;
+  uint8_t bt_queue_max;
+  uint8_t cyw43_arch;  // irq_plan_arch_t
+  uint32_t uptime_ms;
+  uint32_t frames_received;     // BT input reports
+  uint32_t frames_forwarded;    // frames sent to the host
+  uint32_t frames_overwritten;  // frames replaced in the mailbox before pickup
+  uint32_t usb_reports;         // all reports sent, neutral ones included
+  uint32_t timeouts;            // switches to the neutral report
+  bridge_stats_latency_t latency[LATENCY_SPAN_COUNT];
+} bridge_stats_report_t;
+
+_Static_assert(sizeof(bridge_stats_report_t) <= 63, "must fit in one feature report");
+
+// Bluetooth link counters, next to BRIDGE_STATS for lack of room there.
+typedef struct __attribute__((packed)) {
+  uint8_t version;           // BRIDGE_LINK_STATS_VERSION
+  uint32_t bt_out_sent;      // outgoing BT reports sent
+  uint32_t bt_out_merged;    // outgoing BT reports replaced by a newer one while queued
+  uint32_t bt_out_dropped;   // outgoing BT reports dropped, queue full
+  uint32_t bt_out_deferred;  // times the output pacing held the queue back
+  uint32_t bt_crc_errors;    // input reports dropped for a bad CRC
+} bridge_link_stats_report_t;
+
+_Static_assert(sizeof(bridge_link_stats_report_t) <= 63, "must fit in one feature report");
+
+// Core0: snapshot of the counters.
+void bridge_stats_fill(bridge_stats_report_t* report);
+void bridge_stats_fill_link(bridge_link_stats_report_t* report);
+
+#endif  // BRIDGE_STATS_H_
@@ -20,6 +20,9 @@ extern "C" {
 
 void uni_bt_bredr_scan_start(void);
 void uni_bt_bredr_scan_stop(void);
+// Periodic inquiry timing for the next uni_bt_bredr_scan_start(), in 1.28s units, without
+// storing it in the properties. length 0 goes back to the property values.
+void uni_bt_bredr_set_inquiry_timing(uint8_t length, uint8_t min_period, uint8_t max_period);
 
 // Called from uni_hid_device_disconnect()
 void uni_bt_bredr_disconnect(uni_hid_device_t* d);
@@ -31,6 +34,15 @@ void uni_bt_bredr_setup(void);
 void uni_bt_bredr_set_enabled(bool enabled);
 bool uni_bt_bredr_is_enabled(void);
 
+// Connects to a device seen before, without an inquiry: it is handled as if it
+// had just been discovered. clock_offset must include UNI_BT_CLOCK_OFFSET_VALID
+// if it is known. Returns false if the device already exists or no slot is free.
+bool uni_bt_bredr_connect_known_device(bd_addr_t addr,
+                                       uint32_t cod,
+                                       const char* name,
+                                       uint8_t page_scan_repetition_mode,
+                                       uint16_t clock_offset);
+
 void uni_bt_bredr_l2cap_create_control_connection(uni_hid_device_t* d);
 void uni_bt_bredr_process_fsm(uni_hid_device_t* d);
 
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef UNI_BT_SDP_CACHE_H
+#define UNI_BT_SDP_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "uni_hid_device.h"
+
+// Persistent cache of SDP results (Vendor ID, Product ID, controller type and
+// HID descriptor), keyed by BR/EDR address and stored in the BTstack TLV.
+// A controller seen before skips the SDP queries on reconnect.
+// Up to CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES controllers are kept; 0 disables it.
+
+// Fills the device with the cached SDP results. Returns false if the
+// device is not cached, or the cached entry is not usable. A device without
+// a name only hits if its VID/PID is in the controller DB.
+bool uni_bt_sdp_cache_load(uni_hid_device_t* d);
+// Stores the SDP results of the device. Flash is only written if they changed.
+void uni_bt_sdp_cache_store(const uni_hid_device_t* d);
+void uni_bt_sdp_cache_delete(const bd_addr_t addr);
+void uni_bt_sdp_cache_delete_all(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // UNI_BT_SDP_CACHE_H
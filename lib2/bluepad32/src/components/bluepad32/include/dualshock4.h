@@ -10,6 +10,12 @@
 #define DS4_JOYSTICK_MID 0x7F
 #define DS4_JOYSTICK_MAX 0xFF
 
+// Bluetooth input report 0x11, as received after the 0xa1 transaction byte.
+// From byte DS4_BT_REPORT_11_PAYLOAD on it has the same layout as ds4_report_t.
+#define DS4_BT_REPORT_11_ID 0x11
+#define DS4_BT_REPORT_11_LEN 78
+#define DS4_BT_REPORT_11_PAYLOAD 3
+
 #define DS4_BP_UP (1 << 0)
 #define DS4_BP_DOWN (1 << 1)
 #define DS4_BP_RIGHT (1 << 2)
@@ -155,4 +161,12 @@ uint8_t dpad_mask_to_hat(uint8_t mask);
 
 void convert_uni_to_ds4(const uni_gamepad_t gamepad, const uint8_t battery, ds4_report_t* ds4);
 
+// Field-by-field version of convert_uni_to_ds4(). Kept as the reference the
+// table-driven packer must match byte for byte; not used on the hot path.
+void convert_uni_to_ds4_reference(const uni_gamepad_t gamepad, const uint8_t battery, ds4_report_t* ds4);
+
+// Converts the payload of a Bluetooth 0x11 report into a USB report without
+// decoding it. Sensor, touchpad and timestamp data are forwarded unchanged.
+void convert_raw_to_ds4(const uint8_t* payload, ds4_report_t* ds4);
+
 #endif  // DUALSHOCK4_H_
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef FRAME_AGGREGATOR_H_
+#define FRAME_AGGREGATOR_H_
+
+#include "comm.h"
+
+/*
+ * Tap-preserving frame aggregation
+ * --------------------------------
+ * The mailbox only keeps the newest frame, so when several Bluetooth reports
+ * arrive between two USB polls, a button pressed and released in between
+ * would never reach the host. Core1 therefore publishes through this stage:
+ *
+ * - While the previously published frame has not been picked up by core0,
+ *   every new frame is merged with it: pressed buttons stay pressed, a d-pad
+ *   direction is kept if the pad is back in the centre, and triggers keep
+ *   their peak. Sticks and motion data are the newest values.
+ * - Once core0 has picked up the last frame, the next one is published as is.
+ *   With one frame per poll nothing is merged and no latency is added.
+ *
+ * If core0 picks up the previous frame while a merged one is being published,
+ * a release can show up one poll late; taps are never lost.
+ */
+
+#ifndef FRAME_AGGREGATOR_ENABLE
+#define FRAME_AGGREGATOR_ENABLE 1
+#endif
+
+// Average gyro / accelerometer samples of merged frames instead of keeping
+// the newest one.
+#ifndef FRAME_AGGREGATOR_AVERAGE_MOTION
+#define FRAME_AGGREGATOR_AVERAGE_MOTION 0
+#endif
+
+// Core1: publishes the frame in the write slot of g_ds4_shared and wakes up
+// core0. Replaces TRIPLE_BUFFER_PUBLISH() + ds4_shared_notify().
+void frame_aggregator_publish(ds4_frame_t* frame);
+
+#endif  // FRAME_AGGREGATOR_H_
@@ -0,0 +1,40 @@
+#ifndef HOST_OUTPUT_H_
+#define HOST_OUTPUT_H_
+
+#include <stdint.h>
+
+#include <uni_hid_device.h>
+
+/*
+ * Host output reports -> controller
+ * ---------------------------------
+ * Hosts send the DS4 output report (rumble, lightbar) on every change, often
+ * at the USB poll rate. Each update forwarded as is would be a 79-byte report
+ * on the L2CAP interrupt channel, competing with input for radio slots.
+ *
+ * Core0 only posts the latest rumble and lightbar values, one atomic word
+ * each, to a latest-wins mailbox. Core1 checks the mailbox every
+ * HOST_OUTPUT_INTERVAL_MS and applies what changed through the controller's
+ * parser (play_dual_rumble / set_lightbar_color), at most one output report
+ * per check and only when Bluepad32 has nothing queued for the controller.
+ * Intermediate values are dropped; rumble and lightbar take turns when both
+ * changed.
+ *
+ * The host rumble has no duration, so it is played for HOST_OUTPUT_RUMBLE_MS
+ * and played again before that runs out. Blink settings are not forwarded:
+ * Bluepad32 has no API for them.
+ */
+
+#define HOST_OUTPUT_INTERVAL_MS 20   // at most 50 output reports per second
+#define HOST_OUTPUT_RUMBLE_MS 60000  // renewed every HOST_OUTPUT_RUMBLE_MS / 2
+
+// Core0: from the USB output report.
+void host_output_set_rumble(uint8_t weak, uint8_t strong);
+void host_output_set_lightbar(uint8_t r, uint8_t g, uint8_t b);
+
+// Core1 (BTstack run loop).
+void host_output_init(void);
+void host_output_on_ready(uni_hid_device_t* d);
+void host_output_on_disconnected(uni_hid_device_t* d);
+
+#endif  // HOST_OUTPUT_H_
@@ -0,0 +1,45 @@
+#ifndef IRQ_PLAN_H_
+#define IRQ_PLAN_H_
+
+#include <stdint.h>
+
+/*
+ * Interrupt plan
+ * --------------
+ * Each core has its own NVIC, and each peripheral interrupt is only enabled
+ * on the core that owns it:
+ *
+ *   core0  USBCTRL_IRQ      highest priority. TinyUSB only runs from
+ *                           tud_task(); the IRQ just queues events.
+ *   core1  IO_IRQ_BANK0     high priority. The cyw43 data-ready (host wake)
+ *                           line; timestamps the wake and schedules the
+ *                           driver.
+ *          async context    lowest priority (background arch only). Runs the
+ *                           cyw43 driver, BTstack and Bluepad32 right after
+ *                           the wake.
+ *
+ * The cyw43 arch (and BTstack's async context run loop with it) is chosen at
+ * build time with BRIDGE_CYW43_ARCH in CMakeLists.txt:
+ *
+ *   background  pico_cyw43_arch_none (threadsafe background): HCI packets are
+ *               processed from the interrupt, core1 sleeps in WFE otherwise.
+ *   poll        pico_cyw43_arch_poll: the interrupt only wakes the core1 run
+ *               loop, which then polls the driver from thread mode.
+ *
+ * Both sleep when idle. The radio wake -> HCI rx latency span (latency.h)
+ * and the arch reported in BRIDGE_STATS (bridge_stats.h) compare the two.
+ */
+
+typedef enum {
+  IRQ_PLAN_ARCH_BACKGROUND = 0,
+  IRQ_PLAN_ARCH_POLL = 1,
+} irq_plan_arch_t;
+
+// Core0, after tusb_init().
+void irq_plan_core0(void);
+// Core1, after cyw43_arch_init().
+void irq_plan_core1(void);
+
+irq_plan_arch_t irq_plan_get_arch(void);
+
+#endif  // IRQ_PLAN_H_
@@ -5,8 +5,11 @@
 #ifndef UNI_HID_PARSER_H
 #define UNI_HID_PARSER_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "controller/uni_gamepad.h"
+
 // Forward declarations
 struct uni_hid_device_s;
 
@@ -73,10 +76,21 @@ typedef struct {
 } uni_report_parser_t;
 
 void uni_hid_parse_input_report(struct uni_hid_device_s* d, const uint8_t* report, uint16_t report_len);
+// Walks the descriptor with btstack's HID parser and calls parse_usage for each
+// input field. Used when the descriptor has no compiled report map.
+void uni_hid_parser_parse_usages(struct uni_hid_device_s* d,
+                                 const uint8_t* descriptor,
+                                 uint16_t descriptor_len,
+                                 const uint8_t* report,
+                                 uint16_t report_len,
+                                 report_parse_usage_fn_t parse_usage);
 int32_t uni_hid_parser_process_axis(const hid_globals_t* globals, uint32_t value);
 int32_t uni_hid_parser_process_pedal(const hid_globals_t* globals, uint32_t value);
 uint8_t uni_hid_parser_process_hat(const hid_globals_t* globals, uint32_t value);
 void uni_hid_parser_process_dpad(uint16_t usage, uint32_t value, uint8_t* dpad);
 uint8_t uni_hid_parser_hat_to_dpad(uint8_t hat);
+// Sets dpad, buttons and misc_buttons from the 3 button bytes of the DualShock 4
+// and DualSense input reports. Only the DualSense has the mute button (capture).
+void uni_hid_parser_ds_buttons(const uint8_t* buttons, bool has_mute, uni_gamepad_t* gp);
 
 #endif  // UNI_HID_PARSER_H
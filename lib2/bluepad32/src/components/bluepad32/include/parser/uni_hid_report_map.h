@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef UNI_HID_REPORT_MAP_H
+#define UNI_HID_REPORT_MAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "parser/uni_hid_parser.h"
+
+// HID descriptor compiled into per-report-ID tables of input fields.
+//
+// Walking the descriptor with btstack's HID parser for every input report
+// re-parses every item and recomputes every usage. Instead, the descriptor is
+// walked once, when it is set, and each input field is recorded with its bit
+// position, size, usage and globals. A report is then decoded with a loop over
+// the table of its report ID, calling parse_usage() with the same arguments,
+// in the same order, as the btstack walk.
+//
+// Descriptors the table can't represent fall back to the btstack walk
+// ("valid" is false): array input fields (e.g. keyboards), report IDs used
+// by only some fields, or more fields than fit. Needs btstack v1.6.2 or newer.
+
+#define UNI_HID_REPORT_MAP_MAX_FIELDS 128
+#define UNI_HID_REPORT_MAP_MAX_GLOBALS 32
+#define UNI_HID_REPORT_MAP_MAX_REPORTS 8
+
+typedef struct {
+    uint16_t bit_pos;
+    uint16_t usage_page;
+    uint16_t usage;
+    uint8_t size;
+    uint8_t globals_idx;
+} uni_hid_report_field_t;
+
+typedef struct {
+    uint16_t report_id;  // HID_REPORT_ID_UNDEFINED if the descriptor uses none
+    uint8_t first_field;
+    uint8_t num_fields;
+} uni_hid_report_entry_t;
+
+typedef struct {
+    bool valid;
+    uint8_t num_reports;
+    uint8_t num_fields;
+    uint8_t num_globals;
+    uni_hid_report_entry_t reports[UNI_HID_REPORT_MAP_MAX_REPORTS];
+    hid_globals_t globals[UNI_HID_REPORT_MAP_MAX_GLOBALS];
+    uni_hid_report_field_t fields[UNI_HID_REPORT_MAP_MAX_FIELDS];
+} uni_hid_report_map_t;
+
+// Returns false, with map->valid false, if the descriptor can't be compiled.
+bool uni_hid_report_map_compile(uni_hid_report_map_t* map, const uint8_t* descriptor, uint16_t descriptor_len);
+void uni_hid_report_map_parse(const uni_hid_report_map_t* map,
+                              struct uni_hid_device_s* d,
+                              const uint8_t* report,
+                              uint16_t report_len,
+                              report_parse_usage_fn_t parse_usage);
+
+#endif  // UNI_HID_REPORT_MAP_H
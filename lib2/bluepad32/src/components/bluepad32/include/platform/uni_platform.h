@@ -9,6 +9,7 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "uni_error.h"
@@ -65,6 +66,11 @@ struct uni_platform {
     // Indicates that a controller button, stick, gyro, etc. has changed.
     void (*on_controller_data)(uni_hid_device_t* d, uni_controller_t* ctl);
 
+    // Optional. Called with every raw input report (without the 0xa1 transaction byte)
+    // before it gets parsed. Return true if the platform consumed the report, in which
+    // case parsing and on_controller_data are skipped for it.
+    bool (*on_raw_input_report)(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
+
     // Return a property entry, or NULL if not supported.
     const uni_property_t* (*get_property)(uni_property_idx_t idx);
 
@@ -0,0 +1,45 @@
+#ifndef RECONNECT_H_
+#define RECONNECT_H_
+
+#include <stdbool.h>
+
+#include <uni_hid_device.h>
+
+/*
+ * Fast reconnection to the last controller
+ * ----------------------------------------
+ * Link keys stay in flash (BTstack TLV) across power cycles, and the last
+ * controller that became ready is remembered under its own TLV tag. On boot
+ * and after a disconnect the bridge pages that controller directly, staying
+ * page-scan connectable so the controller can also connect by itself. Only
+ * if neither succeeds within RECONNECT_TIMEOUT_MS does it fall back to the
+ * inquiry + autoconnect scan used for new controllers.
+ *
+ * All functions run on core1 (BTstack run loop).
+ */
+
+#define RECONNECT_TIMEOUT_MS 6000  // page timeout (5.12s) plus some slack
+
+// 1 deletes all link keys on boot, forcing a fresh pairing every time.
+#ifndef RECONNECT_FORGET_ON_BOOT
+#define RECONNECT_FORGET_ON_BOOT 0
+#endif
+
+// Starts a directed reconnection, or scanning if no controller is known or
+// the page could not be issued.
+void reconnect_start(void);
+
+// The controller disconnected. Bluepad32 reports it before deleting the
+// device, and a device that still exists cannot be paged: reconnect_start()
+// runs from the next run loop iteration instead.
+void reconnect_on_disconnected(void);
+
+// The device connected / is ready. Stops the fallback timer, and remembers
+// a ready BR/EDR controller for the next reconnection.
+void reconnect_on_connected(uni_hid_device_t* d);
+void reconnect_on_ready(uni_hid_device_t* d);
+
+// True if the connection to this device was initiated by reconnect_start().
+bool reconnect_is_directed(uni_hid_device_t* d);
+
+#endif  // RECONNECT_H_
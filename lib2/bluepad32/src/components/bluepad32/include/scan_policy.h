@@ -0,0 +1,62 @@
+#ifndef SCAN_POLICY_H_
+#define SCAN_POLICY_H_
+
+#include <stdint.h>
+
+/*
+ * Page scan and inquiry duty cycle
+ * --------------------------------
+ * The radio time spent listening for controllers is set by phase:
+ *
+ *   FAST       boot, and SCAN_POLICY_FAST_MS after a disconnect: a controller
+ *              coming back pages the bridge within a few tens of ms. Inquiry
+ *              runs at Bluepad32's default period once reconnect.c falls back
+ *              to it.
+ *   RELAXED    afterwards: standard R1 page scan (1.28s) and a long inquiry
+ *              period, until something connects.
+ *   STREAMING  a controller is connected: no page scan, no inquiry.
+ *
+ * Page scan is interlaced (uni_bt_bredr_setup()), so each interval holds two
+ * back-to-back windows. Time spent in each phase is turned into an estimate of
+ * the radio time spent page scanning and in inquiry, and published with the
+ * connection timeline (connect_stats.h) next to the reconnection latency, so
+ * the numbers below can be tuned against data.
+ *
+ * All functions run on core1 (BTstack run loop).
+ */
+
+#define SCAN_POLICY_FAST_MS 15000
+
+// Page scan interval / window in 0.625ms slots.
+#define SCAN_POLICY_FAST_PAGE_INTERVAL 0x0048     // 45ms, two 11.25ms windows: 50%
+#define SCAN_POLICY_FAST_PAGE_WINDOW 0x0012
+#define SCAN_POLICY_RELAXED_PAGE_INTERVAL 0x0800  // 1.28s, two 11.25ms windows: 1.8%
+#define SCAN_POLICY_RELAXED_PAGE_WINDOW 0x0012
+
+// Periodic inquiry length / min / max period in 1.28s units.
+#define SCAN_POLICY_FAST_INQUIRY_LENGTH 3  // Bluepad32 defaults: 3.84s every 5.1..6.4s
+#define SCAN_POLICY_FAST_INQUIRY_MIN 4
+#define SCAN_POLICY_FAST_INQUIRY_MAX 5
+#define SCAN_POLICY_RELAXED_INQUIRY_LENGTH 3  // 3.84s every 15.4..20.5s
+#define SCAN_POLICY_RELAXED_INQUIRY_MIN 12
+#define SCAN_POLICY_RELAXED_INQUIRY_MAX 16
+
+typedef enum {
+  SCAN_PHASE_FAST = 0,
+  SCAN_PHASE_RELAXED,
+  SCAN_PHASE_STREAMING,
+} scan_phase_t;
+
+// Registers for HCI events and enters the fast phase. Call once after
+// uni_init(), before scanning starts.
+void scan_policy_init(void);
+
+// A controller connected: stop scanning.
+void scan_policy_on_connected(void);
+// The controller disconnected: back to the fast phase. Call before
+// reconnect_start() so that a fallback inquiry uses the fast timing.
+void scan_policy_on_disconnected(void);
+
+scan_phase_t scan_policy_get_phase(void);
+
+#endif  // SCAN_POLICY_H_
@@ -7,7 +7,9 @@
 
 #define CONFIG_BLUEPAD32_MAX_DEVICES 1
 #define CONFIG_BLUEPAD32_MAX_ALLOWLIST 1
+#define CONFIG_BLUEPAD32_SDP_CACHE_ENTRIES 4
 #define CONFIG_BLUEPAD32_GAP_SECURITY 1
 #define CONFIG_BLUEPAD32_ENABLE_BLE_BY_DEFAULT 1
+#define CONFIG_BLUEPAD32_DS4_BT_POLL_INTERVAL_MS 1  // fastest DS4 input rate
 
 #endif  // CONFIG_SDKCONFIG_H_
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef SYNTH_INPUT_H_
+#define SYNTH_INPUT_H_
+
+#include <stdint.h>
+
+/*
+ * Synthetic input generator
+ * -------------------------
+ * With DS4_BRIDGE_MODE_SYNTHETIC, core1 publishes generated frames at a fixed
+ * rate instead of running Bluetooth, so the USB side and the cross-core
+ * hand-off can be load tested without a controller. Each report carries a
+ * sequence number and the core1 publish time in unknown5, which
+ * `tools/ds4.py --loopback` uses to find gaps, duplicates and latency.
+ */
+
+#ifndef SYNTH_INPUT_RATE_HZ
+#define SYNTH_INPUT_RATE_HZ 1000  // 250 to 2000
+#endif
+
+#define SYNTH_INPUT_MIN_RATE_HZ 250
+#define SYNTH_INPUT_MAX_RATE_HZ 2000
+
+// Offsets in ds4_report_t.unknown5, little endian.
+#define SYNTH_INPUT_SEQ_OFFSET 0        // uint32_t sequence number
+#define SYNTH_INPUT_TIMESTAMP_OFFSET 4  // uint32_t time_us_32() at publish
+
+// Core1: generates frames forever.
+void synth_input_run(uint32_t rate_hz);
+
+#endif  // SYNTH_INPUT_H_
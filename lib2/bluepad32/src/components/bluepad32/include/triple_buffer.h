@@ -0,0 +1,118 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+/*
+ * Lock-free single-writer / single-reader triple buffer mailbox
+ * --------------------------------------------------------------
+ * ‑ Three payload slots. The writer owns one (back), the reader owns one
+ *   (front) and the third (middle) is exchanged between them.
+ * ‑ The writer fills its back slot in place and publishes it with a single
+ *   atomic exchange of the middle index. It never waits for the reader.
+ * ‑ The reader swaps its front slot with the middle only when a new frame was
+ *   published, then reads the payload in place. No copy, no retry and no
+ *   torn reads, since neither side ever touches a slot owned by the other.
+ * ‑ If the writer publishes twice before the reader consumes, the older
+ *   frame is dropped and counted in `overwritten`.
+ *
+ * Header‑only; include this in a shared header for both cores.
+ * C11 atomics are used, compatible with C++ as well.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ------------------------------------------------------------------ */
+/*  Public macros                                                      */
+/* ------------------------------------------------------------------ */
+
+#define TRIPLE_BUFFER_INDEX_MASK 0x3u
+#define TRIPLE_BUFFER_FRESH 0x4u /* middle slot holds an unread frame */
+
+/* Declare a triple-buffered structure type.
+ *   TRIPLE_BUFFER_DECL(name, payload_type);
+ * This expands to a struct named <name> with fields:
+ *   payload_type slots[3];      // payload storage
+ *   uint32_t write_idx;         // writer's private slot
+ *   uint32_t read_idx;          // reader's private slot
+ *   _Atomic uint32_t middle;    // exchanged slot | TRIPLE_BUFFER_FRESH
+ *   _Atomic uint32_t overwritten;
+ */
+#define TRIPLE_BUFFER_DECL(name, type) \
+  typedef struct {                     \
+    type slots[3];                     \
+    uint32_t write_idx;                \
+    uint32_t read_idx;                 \
+    _Atomic uint32_t middle;           \
+    _Atomic uint32_t overwritten;      \
+  } name
+
+/* Static initializer: slot 0 to the writer, 1 in the middle, 2 to the reader */
+#define TRIPLE_BUFFER_INIT {.write_idx = 0, .read_idx = 2, .middle = 1, .overwritten = 0}
+
+/* Writer: slot to fill before TRIPLE_BUFFER_PUBLISH() */
+#define TRIPLE_BUFFER_WRITE_SLOT(obj) (&(obj).slots[(obj).write_idx])
+
+/* Writer: make the back slot the latest frame and take the middle one back */
+#define TRIPLE_BUFFER_PUBLISH(obj) triple_buffer_publish(&(obj).middle, &(obj).write_idx, &(obj).overwritten)
+
+/* Writer: true if the last published frame has not been taken by the reader */
+#define TRIPLE_BUFFER_PENDING(obj) \
+  ((atomic_load_explicit(&(obj).middle, memory_order_acquire) & TRIPLE_BUFFER_FRESH) != 0)
+
+/* Reader: returns true if a new frame was published since the last call.
+ * TRIPLE_BUFFER_READ_SLOT() then points to it until the next call. */
+#define TRIPLE_BUFFER_READ(obj) triple_buffer_acquire(&(obj).middle, &(obj).read_idx)
+
+/* Reader: latest acquired frame (payload_type *) */
+#define TRIPLE_BUFFER_READ_SLOT(obj) (&(obj).slots[(obj).read_idx])
+
+static inline void triple_buffer_publish(_Atomic uint32_t* middle,
+                                         uint32_t* write_idx,
+                                         _Atomic uint32_t* overwritten) {
+  uint32_t prev =
+      atomic_exchange_explicit(middle, *write_idx | TRIPLE_BUFFER_FRESH, memory_order_acq_rel);
+  *write_idx = prev & TRIPLE_BUFFER_INDEX_MASK;
+  if (prev & TRIPLE_BUFFER_FRESH) {
+    atomic_fetch_add_explicit(overwritten, 1u, memory_order_relaxed);
+  }
+}
+
+static inline bool triple_buffer_acquire(_Atomic uint32_t* middle, uint32_t* read_idx) {
+  if (!(atomic_load_explicit(middle, memory_order_relaxed) & TRIPLE_BUFFER_FRESH)) {
+    return false;
+  }
+  uint32_t prev = atomic_exchange_explicit(middle, *read_idx, memory_order_acq_rel);
+  *read_idx = prev & TRIPLE_BUFFER_INDEX_MASK;
+  return true;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Example                                                           */
+/* ------------------------------------------------------------------ */
+/*
+#include "triple_buffer.h"
+#include "uni_gamepad.h"
+
+TRIPLE_BUFFER_DECL(shared_ctrl_t, uni_gamepad_t);
+
+// Shared instance (place in .bss and ensure 32‑byte alignment)
+shared_ctrl_t g_ctrl __attribute__((aligned(32))) = TRIPLE_BUFFER_INIT;
+
+// Writer (Bluetooth core)
+void bt_new_packet(const uni_gamepad_t *src)
+{
+    *TRIPLE_BUFFER_WRITE_SLOT(g_ctrl) = *src;
+    TRIPLE_BUFFER_PUBLISH(g_ctrl);
+}
+
+// Reader (USB core)
+const uni_gamepad_t* usb_get_latest(void)
+{
+    if (!TRIPLE_BUFFER_READ(g_ctrl))
+        return NULL;  // nothing new
+    return TRIPLE_BUFFER_READ_SLOT(g_ctrl);
+}
+*/
+
+#endif /* TRIPLE_BUFFER_H */
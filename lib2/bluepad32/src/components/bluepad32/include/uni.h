@@ -36,7 +36,6 @@ extern "C" {
 #include "parser/uni_hid_parser_mouse.h"
 #include "parser/uni_hid_parser_xboxone.h"
 #include "platform/uni_platform.h"
-#include "uni_circular_buffer.h"
 #include "uni_console.h"
 #include "uni_hid_device.h"
 #include "uni_init.h"
@@ -17,4 +17,12 @@
 #endif
 #endif
 
+// v1.6.2 rewrote the HID parser on top of btstack_hid_usage_iterator_t.
+// Minimum version is 1.6.1
+#if BTSTACK_VERSION_MAJOR > 1 || BTSTACK_VERSION_MINOR > 6 || BTSTACK_VERSION_PATCH > 1
+#define USE_NEW_PARSER_API 1
+#else
+#define USE_NEW_PARSER_API 0
+#endif
+
 #endif  // UNI_BTSTACK_VERSION_COMPAT_H
@@ -13,8 +13,9 @@
 #include "controller/uni_controller.h"
 #include "controller/uni_controller_type.h"
 #include "parser/uni_hid_parser.h"
-#include "uni_circular_buffer.h"
+#include "parser/uni_hid_report_map.h"
 #include "uni_error.h"
+#include "uni_output_queue.h"
 
 #define HID_MAX_NAME_LEN 240
 #define HID_MAX_DESCRIPTOR_LEN 512
@@ -46,6 +47,8 @@ struct uni_hid_device_s {
     // SDP
     uint8_t hid_descriptor[HID_MAX_DESCRIPTOR_LEN];
     uint16_t hid_descriptor_len;
+    // Input fields of hid_descriptor, decoded without re-parsing it.
+    uni_hid_report_map_t report_map;
     // DualShock4 1st gen requires to do the SDP query before l2cap connect,
     // otherwise it won't work.
     // And Nintendo Switch Pro gamepad requires to do the SDP query after l2cap
@@ -55,6 +58,8 @@ struct uni_hid_device_s {
     // debug the Linux connection and see what packets are sent before the
     // connection.
     uni_sdp_query_type_t sdp_query_type;
+    // SDP results were loaded from uni_bt_sdp_cache instead of queried.
+    bool sdp_cached;
 
     // Channels
     uint16_t hids_cid;  // BLE only
@@ -76,9 +81,8 @@ struct uni_hid_device_s {
     // Needed for Nintendo Switch family of controllers.
     btstack_timer_source_t misc_button_delay_timer;
 
-    // Circular buffer that contains the outgoing packets that couldn't be sent
-    // immediately.
-    uni_circular_buffer_t outgoing_buffer;
+    // Outgoing reports that couldn't be sent immediately.
+    uni_output_queue_t output_queue;
 
     // Bytes reserved to controller's parser instances.
     // E.g.: The Wii driver uses it for the state machine.
@@ -169,13 +173,16 @@ void uni_hid_device_dump_all(void);
 bool uni_hid_device_guess_controller_type_from_name(uni_hid_device_t* d, const char* name);
 void uni_hid_device_guess_controller_type_from_pid_vid(uni_hid_device_t* d);
 bool uni_hid_device_has_controller_type(const uni_hid_device_t* d);
+void uni_hid_device_clear_controller_type(uni_hid_device_t* d);
 
 void uni_hid_device_process_controller(uni_hid_device_t* d);
+void uni_hid_device_process_misc_buttons(uni_hid_device_t* d);
 
 void uni_hid_device_set_connection_handle(uni_hid_device_t* d, hci_con_handle_t handle);
 
 void uni_hid_device_send_report(uni_hid_device_t* d, uint16_t cid, const uint8_t* report, uint16_t len);
 void uni_hid_device_send_intr_report(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
+void uni_hid_device_send_intr_report_latest(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
 void uni_hid_device_send_ctrl_report(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
 void uni_hid_device_send_queued_reports(uni_hid_device_t* d);
 
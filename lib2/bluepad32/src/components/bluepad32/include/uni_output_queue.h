@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef UNI_OUTPUT_QUEUE_H
+#define UNI_OUTPUT_QUEUE_H
+
+#include <btstack.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Per-device scheduler for outgoing L2CAP reports (rumble, LEDs, feature
+// requests).
+//
+// A report is sent right away when nothing is queued and the link can take
+// it. Otherwise it is queued, in order, and the queue is drained on
+// L2CAP_EVENT_CAN_SEND_NOW: as many reports as the link accepts per event.
+//
+// Reports that carry the complete output state of the device (e.g. DS4 report
+// 0x11) can be sent as "replaceable": a queued report with the same channel,
+// header and length is overwritten in place instead, so only the newest state
+// goes out.
+//
+// Output is paced with a token bucket: at most UNI_OUTPUT_QUEUE_BURST reports
+// back to back, then one every UNI_OUTPUT_QUEUE_REFILL_MS, so a parser that
+// sends on every change can't fill the baseband with output and delay input.
+
+// How many reports can be queued per device.
+#define UNI_OUTPUT_QUEUE_SIZE 16
+// Max size of each report.
+#define UNI_OUTPUT_QUEUE_DATA_SIZE 128
+#define UNI_OUTPUT_QUEUE_BURST 4
+#define UNI_OUTPUT_QUEUE_REFILL_MS 4
+
+typedef struct {
+    uint16_t cid;
+    uint8_t len;
+    bool replaceable;
+    uint8_t data[UNI_OUTPUT_QUEUE_DATA_SIZE];
+} uni_output_queue_entry_t;
+
+typedef struct uni_output_queue_s {
+    uni_output_queue_entry_t entries[UNI_OUTPUT_QUEUE_SIZE];
+    uint8_t head;
+    uint8_t count;
+    uint8_t max_count;   // since the device was created
+    uint8_t tokens_used;  // token bucket, 0 means full
+    uint32_t refill_ms;
+    btstack_timer_source_t pace_timer;
+    bool pace_timer_armed;
+} uni_output_queue_t;
+
+// Totals over all devices. Free running.
+typedef struct {
+    uint32_t sent;
+    uint32_t merged;    // replaced by a newer report while queued
+    uint32_t dropped;   // queue full or report too big
+    uint32_t deferred;  // times the pacing held the queue back
+} uni_output_queue_stats_t;
+
+void uni_output_queue_send(uni_output_queue_t* q, uint16_t cid, const uint8_t* report, uint16_t len, bool replaceable);
+// Sends queued reports until the link or the pacing says stop.
+void uni_output_queue_flush(uni_output_queue_t* q);
+// Drops everything queued. Must be called before the queue memory is reused.
+void uni_output_queue_reset(uni_output_queue_t* q);
+
+uint8_t uni_output_queue_get_depth(const uni_output_queue_t* q);
+bool uni_output_queue_is_empty(const uni_output_queue_t* q);
+const uni_output_queue_stats_t* uni_output_queue_get_stats(void);
+
+#endif  // UNI_OUTPUT_QUEUE_H
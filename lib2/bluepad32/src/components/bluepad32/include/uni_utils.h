@@ -5,12 +5,42 @@
 #ifndef UNI_UTILS_H
 #define UNI_UTILS_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+typedef uint32_t (*uni_crc32_fn_t)(uint32_t crc, const uint8_t* data, size_t len);
+
 // Little-endian CRC32.
 // ESP32 has its own crc32_le as well, but they don't return the same values (?).
 // It is important to use ours with the "uni_" prefix.
+// Uses the engine set with uni_crc32_set_engine(), slice-by-4 tables by default.
 uint32_t uni_crc32_le(uint32_t crc, const uint8_t* data, size_t len);
 
+// Software engines, same results: one bit at a time, and slice-by-4 tables.
+uint32_t uni_crc32_le_bitwise(uint32_t crc, const uint8_t* data, size_t len);
+uint32_t uni_crc32_le_table(uint32_t crc, const uint8_t* data, size_t len);
+
+// Lets the platform plug a hardware CRC engine. NULL restores the tables.
+void uni_crc32_set_engine(uni_crc32_fn_t fn);
+
+// multiplier / divisor, prepared once to scale int16 samples without dividing.
+// uni_frac_mul() returns the same as (int32_t)mult_frac(multiplier, x, divisor)
+// as long as |divisor| < 2^17, which holds for any divisor computed from int16
+// calibration values.
+typedef struct {
+    uint32_t quot;  // |multiplier| / |divisor|
+    uint32_t frac;  // remainder / |divisor|, 0.32 fixed point rounded up
+    bool negative;
+} uni_frac_t;
+
+void uni_frac_init(uni_frac_t* f, int32_t multiplier, int32_t divisor);
+
+static inline int32_t uni_frac_mul(const uni_frac_t* f, int16_t x) {
+    uint32_t n = x < 0 ? -(int32_t)x : x;
+    // The rounding error of frac stays below 1/divisor: the integer part is exact.
+    uint64_t mag = (uint64_t)n * f->quot + (((uint64_t)n * f->frac) >> 32);
+    return (int32_t)(uint32_t)((x < 0) != f->negative ? -mag : mag);
+}
+
 #endif  // UNI_UTILS_H
@@ -5,6 +5,7 @@
 #include "parser/uni_hid_parser.h"
 
 #include "hid_usage.h"
+#include "parser/uni_hid_report_map.h"
 #include "uni_btstack_version_compat.h"
 #include "uni_hid_device.h"
 #include "uni_log.h"
@@ -13,16 +14,7 @@
 // HID Usage Tables:
 // https://www.usb.org/sites/default/files/documents/hut1_12v2.pdf
 
-// Minimum version is 1.6.1
-#if BTSTACK_VERSION_MAJOR > 1 || BTSTACK_VERSION_MINOR > 6 || BTSTACK_VERSION_PATCH > 1
-#define USE_NEW_PARSER_API 1
-#else
-#define USE_NEW_PARSER_API 0
-#endif
-
 void uni_hid_parse_input_report(struct uni_hid_device_s* d, const uint8_t* report, uint16_t report_len) {
-    btstack_hid_parser_t parser;
-
     uni_report_parser_t* rp = &d->report_parser;
 
     //    printf_hexdump(report, report_len);
@@ -39,37 +31,51 @@ void uni_hid_parse_input_report(struct uni_hid_device_s* d, const uint8_t* repor
 
     // Devices that suport regular HID reports.
     if (rp->parse_usage) {
-        btstack_hid_parser_init(&parser, d->hid_descriptor, d->hid_descriptor_len, HID_REPORT_TYPE_INPUT, report,
-                                report_len);
-        while (btstack_hid_parser_has_more(&parser)) {
-            uint16_t usage_page;
-            uint16_t usage;
-            int32_t value;
-            hid_globals_t globals;
-
-            // Save globals, since they are destroyed by btstack_hid_parser_get_field()
-            // see: https://github.com/bluekitchen/btstack/issues/187
+        if (d->report_map.valid)
+            uni_hid_report_map_parse(&d->report_map, d, report, report_len, rp->parse_usage);
+        else
+            uni_hid_parser_parse_usages(d, d->hid_descriptor, d->hid_descriptor_len, report, report_len,
+                                        rp->parse_usage);
+    }
+}
+
+void uni_hid_parser_parse_usages(struct uni_hid_device_s* d,
+                                 const uint8_t* descriptor,
+                                 uint16_t descriptor_len,
+                                 const uint8_t* report,
+                                 uint16_t report_len,
+                                 report_parse_usage_fn_t parse_usage) {
+    btstack_hid_parser_t parser;
+
+    btstack_hid_parser_init(&parser, descriptor, descriptor_len, HID_REPORT_TYPE_INPUT, report, report_len);
+    while (btstack_hid_parser_has_more(&parser)) {
+        uint16_t usage_page;
+        uint16_t usage;
+        int32_t value;
+        hid_globals_t globals;
+
+        // Save globals, since they are destroyed by btstack_hid_parser_get_field()
+        // see: https://github.com/bluekitchen/btstack/issues/187
 #if USE_NEW_PARSER_API
-            globals.logical_minimum = parser.usage_iterator.global_logical_minimum;
-            globals.logical_maximum = parser.usage_iterator.global_logical_maximum;
-            globals.report_count = parser.usage_iterator.global_report_count;
-            globals.report_id = parser.usage_iterator.global_report_id;
-            globals.report_size = parser.usage_iterator.global_report_size;
-            globals.usage_page = parser.usage_iterator.global_usage_page;
+        globals.logical_minimum = parser.usage_iterator.global_logical_minimum;
+        globals.logical_maximum = parser.usage_iterator.global_logical_maximum;
+        globals.report_count = parser.usage_iterator.global_report_count;
+        globals.report_id = parser.usage_iterator.global_report_id;
+        globals.report_size = parser.usage_iterator.global_report_size;
+        globals.usage_page = parser.usage_iterator.global_usage_page;
 #else
-            globals.logical_minimum = parser.global_logical_minimum;
-            globals.logical_maximum = parser.global_logical_maximum;
-            globals.report_count = parser.global_report_count;
-            globals.report_id = parser.global_report_id;
-            globals.report_size = parser.global_report_size;
-            globals.usage_page = parser.global_usage_page;
+        globals.logical_minimum = parser.global_logical_minimum;
+        globals.logical_maximum = parser.global_logical_maximum;
+        globals.report_count = parser.global_report_count;
+        globals.report_id = parser.global_report_id;
+        globals.report_size = parser.global_report_size;
+        globals.usage_page = parser.global_usage_page;
 #endif
 
-            btstack_hid_parser_get_field(&parser, &usage_page, &usage, &value);
+        btstack_hid_parser_get_field(&parser, &usage_page, &usage, &value);
 
-            logd("usage_page = 0x%04x, usage = 0x%04x, value = 0x%x\n", usage_page, usage, value);
-            rp->parse_usage(d, &globals, usage_page, usage, value);
-        }
+        logd("usage_page = 0x%04x, usage = 0x%04x, value = 0x%x\n", usage_page, usage, value);
+        parse_usage(d, &globals, usage_page, usage, value);
     }
 }
 
@@ -196,3 +202,37 @@ uint8_t uni_hid_parser_hat_to_dpad(uint8_t hat) {
     }
     return dpad;
 }
+
+// DualShock 4 / DualSense buttons, one table lookup per nibble instead of a test per button.
+#define DS_BIT(i, n, v) ((((i) >> (n)) & 1) ? (v) : 0)
+#define DS_TABLE16(f) \
+    {f(0), f(1), f(2), f(3), f(4), f(5), f(6), f(7), f(8), f(9), f(10), f(11), f(12), f(13), f(14), f(15)}
+
+// buttons[0] & 0x0f: hat, 8 and above is centered.
+static const uint8_t ds_dpad[16] = {
+    DPAD_UP, DPAD_UP | DPAD_RIGHT, DPAD_RIGHT, DPAD_RIGHT | DPAD_DOWN,
+    DPAD_DOWN, DPAD_DOWN | DPAD_LEFT, DPAD_LEFT, DPAD_LEFT | DPAD_UP,
+};
+// buttons[0] >> 4: Square (West), Cross (South), Circle (East), Triangle (North).
+#define DS_FACE(i) (DS_BIT(i, 0, BUTTON_X) | DS_BIT(i, 1, BUTTON_A) | DS_BIT(i, 2, BUTTON_B) | DS_BIT(i, 3, BUTTON_Y))
+static const uint16_t ds_face[16] = DS_TABLE16(DS_FACE);
+// buttons[1] & 0x0f: L1, R1, L2, R2.
+#define DS_SHOULDER(i)                                                                                   \
+    (DS_BIT(i, 0, BUTTON_SHOULDER_L) | DS_BIT(i, 1, BUTTON_SHOULDER_R) | DS_BIT(i, 2, BUTTON_TRIGGER_L) | \
+     DS_BIT(i, 3, BUTTON_TRIGGER_R))
+static const uint16_t ds_shoulder[16] = DS_TABLE16(DS_SHOULDER);
+// buttons[1] >> 4: Share, Options (misc), L3, R3.
+#define DS_THUMB(i) (DS_BIT(i, 2, BUTTON_THUMB_L) | DS_BIT(i, 3, BUTTON_THUMB_R))
+static const uint16_t ds_thumb[16] = DS_TABLE16(DS_THUMB);
+#define DS_MISC(i) (DS_BIT(i, 0, MISC_BUTTON_SELECT) | DS_BIT(i, 1, MISC_BUTTON_START))
+static const uint8_t ds_misc[16] = DS_TABLE16(DS_MISC);
+// buttons[2] & 0x0f: PS, touchpad click (not a gamepad button), mute.
+#define DS_SYSTEM(i) (DS_BIT(i, 0, MISC_BUTTON_SYSTEM) | DS_BIT(i, 2, MISC_BUTTON_CAPTURE))
+static const uint8_t ds_system[16] = DS_TABLE16(DS_SYSTEM);
+
+void uni_hid_parser_ds_buttons(const uint8_t* buttons, bool has_mute, uni_gamepad_t* gp) {
+    gp->dpad = ds_dpad[buttons[0] & 0x0f];
+    gp->buttons = ds_face[buttons[0] >> 4] | ds_shoulder[buttons[1] & 0x0f] | ds_thumb[buttons[1] >> 4];
+    // The DualShock 4 has a report counter in the upper bits of buttons[2].
+    gp->misc_buttons = ds_misc[buttons[1] >> 4] | ds_system[buttons[2] & (has_mute ? 0x05 : 0x01)];
+}
@@ -32,6 +32,17 @@
 #define DS4_GYRO_RES_PER_DEG_S 1024
 #define DS4_GYRO_RANGE (2048 * DS4_GYRO_RES_PER_DEG_S)
 
+// First byte of the output report: hardware control flags + Bluetooth poll
+// interval in ms. The controller applies the interval to its 0x11 input reports.
+#define DS4_OUTPUT_HWCTL_BT_POLL_MASK 0x3f
+#define DS4_OUTPUT_HWCTL_CRC32 0x40
+#define DS4_OUTPUT_HWCTL_HID 0x80
+#ifndef CONFIG_BLUEPAD32_DS4_BT_POLL_INTERVAL_MS
+#define CONFIG_BLUEPAD32_DS4_BT_POLL_INTERVAL_MS 4
+#endif
+_Static_assert(CONFIG_BLUEPAD32_DS4_BT_POLL_INTERVAL_MS <= DS4_OUTPUT_HWCTL_BT_POLL_MASK,
+               "DS4 poll interval must fit in 6 bits");
+
 // When sending the FF report, which "features" should be set.
 enum {
     DS4_FF_FLAG_RUMBLE = 1 << 0,
@@ -51,6 +62,7 @@ struct ds4_calibration_data {
     int16_t bias;
     int32_t sens_numer;
     int32_t sens_denom;
+    uni_frac_t scale;  // sens_numer / sens_denom, see ds4_update_calibration_scales()
 };
 
 typedef struct {
@@ -216,12 +228,13 @@ static void ds4_play_dual_rumble_now(uni_hid_device_t* d,
                                      uint8_t weak_magnitude,
                                      uint8_t strong_magnitude);
 static void ds4_parse_mouse(uni_hid_device_t* d, const ds4_input_report_11_t* r);
+static void ds4_update_calibration_scales(ds4_instance_t* ins);
 
 void uni_hid_parser_ds4_setup(struct uni_hid_device_s* d) {
     ds4_instance_t* ins = get_ds4_instance(d);
     memset(ins, 0, sizeof(*ins));
 
-    // Default values for Accel / Gyro calibration data, until calibration is supported.
+    // Default values for Accel / Gyro calibration data, until the calibration report lands.
     for (size_t i = 0; i < ARRAY_SIZE(ins->accel_calib_data); i++) {
         ins->gyro_calib_data[i].bias = 0;
         ins->gyro_calib_data[i].sens_numer = DS4_GYRO_RANGE;
@@ -231,12 +244,22 @@ void uni_hid_parser_ds4_setup(struct uni_hid_device_s* d) {
         ins->accel_calib_data[i].sens_numer = DS4_ACC_RANGE;
         ins->accel_calib_data[i].sens_denom = INT16_MAX;
     }
+    ds4_update_calibration_scales(ins);
+
+    // Every input report sets the whole controller state: it is cleared once here
+    // instead of before each report.
+    uni_hid_parser_ds4_init_report(d);
 
-    // Send in order:
+    // Send:
+    // - calibration report: enables report 0x11 on some devices. Requested first, since
+    //   it is a round trip on the control channel.
     // - enable lightbar: enables light and enables report 0x11 on most devices
-    // - calibration report: enables report 0x11 on other reports
-    ds4_send_enable_lightbar_report(d);
     ds4_request_calibration_report(d);
+    ds4_send_enable_lightbar_report(d);
+    // Ready without waiting for the answers: input is parsed with the default
+    // calibration meanwhile, and the calibration is applied when it lands.
+    // The firmware version is requested after it, since only one GET_REPORT
+    // can be outstanding on the control channel.
     if (!uni_hid_device_set_ready_complete(d))
         return;
 
@@ -259,7 +282,9 @@ void uni_hid_parser_ds4_setup(struct uni_hid_device_s* d) {
         // Could happen that the platform rejects the virtual device.
         // E.g: Mouse not supported. If that's the case, break the link
         d->child = NULL;
+        return;
     }
+    uni_hid_parser_ds4_init_report(d);
 }
 
 void uni_hid_parser_ds4_init_report(uni_hid_device_t* d) {
@@ -353,6 +378,7 @@ void uni_hid_parser_ds4_parse_feature_report(uni_hid_device_t* d, const uint8_t*
                     ins->accel_calib_data[i].sens_denom = INT16_MAX;
                 }
             }
+            ds4_update_calibration_scales(ins);
             ds4_request_firmware_version_report(d);
             break;
         }
@@ -385,44 +411,17 @@ static void ds4_parse_input_report_01(uni_hid_device_t* d, const ds4_input_repor
     ctl->gamepad.axis_rx = (r->rx - 127) * 4;
     ctl->gamepad.axis_ry = (r->ry - 127) * 4;
 
-    // Hat
-    uint8_t value = r->buttons[0] & 0xf;
-    if (value > 7)
-        value = 0xff; /* Center 0, 0 */
-    ctl->gamepad.dpad = uni_hid_parser_hat_to_dpad(value);
-
-    // Buttons
-    // TODO: ds4, ds5 have these buttons in common. Refactor.
-    if (r->buttons[0] & 0x10)
-        ctl->gamepad.buttons |= BUTTON_X;  // West
-    if (r->buttons[0] & 0x20)
-        ctl->gamepad.buttons |= BUTTON_A;  // South
-    if (r->buttons[0] & 0x40)
-        ctl->gamepad.buttons |= BUTTON_B;  // East
-    if (r->buttons[0] & 0x80)
-        ctl->gamepad.buttons |= BUTTON_Y;  // North
-    if (r->buttons[1] & 0x01)
-        ctl->gamepad.buttons |= BUTTON_SHOULDER_L;  // L1
-    if (r->buttons[1] & 0x02)
-        ctl->gamepad.buttons |= BUTTON_SHOULDER_R;  // R1
-    if (r->buttons[1] & 0x04)
-        ctl->gamepad.buttons |= BUTTON_TRIGGER_L;  // L2
-    if (r->buttons[1] & 0x08)
-        ctl->gamepad.buttons |= BUTTON_TRIGGER_R;  // R2
-    if (r->buttons[1] & 0x10)
-        ctl->gamepad.misc_buttons |= MISC_BUTTON_SELECT;  // Share
-    if (r->buttons[1] & 0x20)
-        ctl->gamepad.misc_buttons |= MISC_BUTTON_START;  // Options
-    if (r->buttons[1] & 0x40)
-        ctl->gamepad.buttons |= BUTTON_THUMB_L;  // Thumb L
-    if (r->buttons[1] & 0x80)
-        ctl->gamepad.buttons |= BUTTON_THUMB_R;  // Thumb R
-    if (r->buttons[2] & 0x01)
-        ctl->gamepad.misc_buttons |= MISC_BUTTON_SYSTEM;  // PS
+    // Hat + buttons
+    uni_hid_parser_ds_buttons(r->buttons, false, &ctl->gamepad);
 
     // Brake & throttle
     ctl->gamepad.brake = r->brake * 4;
     ctl->gamepad.throttle = r->throttle * 4;
+
+    // No motion sensors nor battery in this report.
+    memset(ctl->gamepad.gyro, 0, sizeof(ctl->gamepad.gyro));
+    memset(ctl->gamepad.accel, 0, sizeof(ctl->gamepad.accel));
+    ctl->battery = 0;
 }
 
 static void ds4_parse_input_report_11(uni_hid_device_t* d, const ds4_input_report_11_t* r) {
@@ -435,60 +434,20 @@ static void ds4_parse_input_report_11(uni_hid_device_t* d, const ds4_input_repor
     ctl->gamepad.axis_rx = (r->rx - 127) * 4;
     ctl->gamepad.axis_ry = (r->ry - 127) * 4;
 
-    // Hat
-    uint8_t value = r->buttons[0] & 0xf;
-    if (value > 7)
-        value = 0xff; /* Center 0, 0 */
-    ctl->gamepad.dpad = uni_hid_parser_hat_to_dpad(value);
-
-    // Buttons
-    // TODO: ds4, ds5 have these buttons in common. Refactor.
-    if (r->buttons[0] & 0x10)
-        ctl->gamepad.buttons |= BUTTON_X;  // West
-    if (r->buttons[0] & 0x20)
-        ctl->gamepad.buttons |= BUTTON_A;  // South
-    if (r->buttons[0] & 0x40)
-        ctl->gamepad.buttons |= BUTTON_B;  // East
-    if (r->buttons[0] & 0x80)
-        ctl->gamepad.buttons |= BUTTON_Y;  // North
-    if (r->buttons[1] & 0x01)
-        ctl->gamepad.buttons |= BUTTON_SHOULDER_L;  // L1
-    if (r->buttons[1] & 0x02)
-        ctl->gamepad.buttons |= BUTTON_SHOULDER_R;  // R1
-    if (r->buttons[1] & 0x04)
-        ctl->gamepad.buttons |= BUTTON_TRIGGER_L;  // L2
-    if (r->buttons[1] & 0x08)
-        ctl->gamepad.buttons |= BUTTON_TRIGGER_R;  // R2
-    if (r->buttons[1] & 0x10)
-        ctl->gamepad.misc_buttons |= MISC_BUTTON_SELECT;  // Share
-    if (r->buttons[1] & 0x20)
-        ctl->gamepad.misc_buttons |= MISC_BUTTON_START;  // Options
-    if (r->buttons[1] & 0x40)
-        ctl->gamepad.buttons |= BUTTON_THUMB_L;  // Thumb L
-    if (r->buttons[1] & 0x80)
-        ctl->gamepad.buttons |= BUTTON_THUMB_R;  // Thumb R
-    if (r->buttons[2] & 0x01)
-        ctl->gamepad.misc_buttons |= MISC_BUTTON_SYSTEM;  // PS
+    // Hat + buttons
+    uni_hid_parser_ds_buttons(r->buttons, false, &ctl->gamepad);
 
     // Brake & throttle
     ctl->gamepad.brake = r->brake * 4;
     ctl->gamepad.throttle = r->throttle * 4;
 
     // Gyro
-    for (size_t i = 0; i < ARRAY_SIZE(r->gyro); i++) {
-        int32_t raw_data = (int16_t)r->gyro[i];
-        int32_t calib_data =
-            mult_frac(ins->gyro_calib_data[i].sens_numer, raw_data, ins->gyro_calib_data[i].sens_denom);
-        ctl->gamepad.gyro[i] = calib_data;
-    }
+    for (size_t i = 0; i < ARRAY_SIZE(r->gyro); i++)
+        ctl->gamepad.gyro[i] = uni_frac_mul(&ins->gyro_calib_data[i].scale, (int16_t)r->gyro[i]);
 
     // Accel
-    for (size_t i = 0; i < ARRAY_SIZE(r->accel); i++) {
-        int32_t raw_data = (int16_t)r->accel[i];
-        int32_t calib_data =
-            mult_frac(ins->accel_calib_data[i].sens_numer, raw_data, ins->accel_calib_data[i].sens_denom);
-        ctl->gamepad.accel[i] = calib_data;
-    }
+    for (size_t i = 0; i < ARRAY_SIZE(r->accel); i++)
+        ctl->gamepad.accel[i] = uni_frac_mul(&ins->accel_calib_data[i].scale, (int16_t)r->accel[i]);
 
     // Value goes from 0 to 10. Make it from 0 to 250.
     // The +1 is to avoid having a value of 0, which means "battery unavailable".
@@ -508,6 +467,8 @@ void uni_hid_parser_ds4_parse_input_report(uni_hid_device_t* d, const uint8_t* r
         ds4_parse_input_report_01(d, r);
     } else {
         loge("DS4: Unexpected report type and len: report id=0x%02x, len=%d\n", report[0], len);
+        // The controller is processed anyway: report it released, as before.
+        uni_hid_parser_ds4_init_report(d);
     }
 }
 
@@ -587,13 +548,27 @@ static ds4_instance_t* get_ds4_instance(uni_hid_device_t* d) {
     return (ds4_instance_t*)&d->parser_data[0];
 }
 
+// Input reports scale the motion samples with a multiply instead of mult_frac():
+// the divisions are done here, each time the calibration changes.
+static void ds4_update_calibration_scales(ds4_instance_t* ins) {
+    for (size_t i = 0; i < ARRAY_SIZE(ins->gyro_calib_data); i++) {
+        struct ds4_calibration_data* c = &ins->gyro_calib_data[i];
+        uni_frac_init(&c->scale, c->sens_numer, c->sens_denom);
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(ins->accel_calib_data); i++) {
+        struct ds4_calibration_data* c = &ins->accel_calib_data[i];
+        uni_frac_init(&c->scale, c->sens_numer, c->sens_denom);
+    }
+}
+
 static void ds4_send_output_report(uni_hid_device_t* d, ds4_output_report_t* out) {
     out->transaction_type = (HID_MESSAGE_TYPE_DATA << 4) | HID_REPORT_TYPE_OUTPUT;
     out->report_id = 0x11;  // taken from HID descriptor
-    out->unk0[0] = 0xc4;    // HID alone + poll interval
+    out->unk0[0] = DS4_OUTPUT_HWCTL_HID | DS4_OUTPUT_HWCTL_CRC32 | CONFIG_BLUEPAD32_DS4_BT_POLL_INTERVAL_MS;
     out->crc32 = ~uni_crc32_le(0xffffffff, (uint8_t*)out, sizeof(*out) - 4);
 
-    uni_hid_device_send_intr_report(d, (uint8_t*)out, sizeof(*out));
+    // Every report sets rumble, color and blink: a newer one supersedes a queued one.
+    uni_hid_device_send_intr_report_latest(d, (uint8_t*)out, sizeof(*out));
 }
 
 static void ds4_stop_rumble_now(uni_hid_device_t* d) {
@@ -737,6 +712,9 @@ static void ds4_parse_mouse(uni_hid_device_t* d, const ds4_input_report_11_t* r)
         ctl->mouse.delta_x = 0;
         ctl->mouse.delta_y = 0;
     }
+    ctl->mouse.buttons = 0;
+    ctl->mouse.scroll_wheel = 0;
+    ctl->mouse.misc_buttons = 0;
 
     // "Click" on Touchpad
     if (r->buttons[2] & 0x02) {
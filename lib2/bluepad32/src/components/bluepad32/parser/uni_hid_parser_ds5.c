@@ -87,6 +87,7 @@ struct ds5_calibration_data {
     int16_t bias;
     int32_t sens_numer;
     int32_t sens_denom;
+    uni_frac_t scale;  // sens_numer / sens_denom, see ds5_update_calibration_scales()
 };
 
 typedef struct {
@@ -241,6 +242,7 @@ static void ds5_play_dual_rumble_now(uni_hid_device_t* d,
                                      uint8_t weak_magnitude,
                                      uint8_t strong_magnitude);
 static void ds5_parse_mouse(uni_hid_device_t* d, const uint8_t* report, uint16_t len);
+static void ds5_update_calibration_scales(ds5_instance_t* ins);
 
 ds5_adaptive_trigger_effect_t ds5_new_adaptive_trigger_effect_off(void) {
     ds5_adaptive_trigger_effect_t out;
@@ -417,6 +419,11 @@ void uni_hid_parser_ds5_setup(uni_hid_device_t* d) {
         ins->accel_calib_data[i].sens_numer = DS5_ACC_RANGE;
         ins->accel_calib_data[i].sens_denom = INT16_MAX;
     }
+    ds5_update_calibration_scales(ins);
+
+    // Every input report sets the whole controller state: it is cleared once here
+    // instead of before each report.
+    uni_hid_parser_ds5_init_report(d);
 
     ds5_request_pairing_info_report(d);
 }
@@ -543,6 +550,7 @@ void uni_hid_parser_ds5_parse_feature_report(uni_hid_device_t* d, const uint8_t*
                     ins->accel_calib_data[i].sens_denom = INT16_MAX;
                 }
             }
+            ds5_update_calibration_scales(ins);
 
             ds5_send_enable_lightbar_report(d);
             break;
@@ -559,15 +567,20 @@ void uni_hid_parser_ds5_parse_input_report(uni_hid_device_t* d, const uint8_t* r
 
     // Don't process reports until state is ready. Prevents possible div-by-0 on calibration
     // and ignores other warnings.
-    if (ins->state != DS5_STATE_READY)
+    // The controller is processed anyway: report it released, as before.
+    if (ins->state != DS5_STATE_READY) {
+        uni_hid_parser_ds5_init_report(d);
         return;
+    }
 
     if (report[0] != 0x31) {
         loge("DS5: Unexpected report type: got 0x%02x, want: 0x31\n", report[0]);
+        uni_hid_parser_ds5_init_report(d);
         return;
     }
     if (len != 78) {
         loge("DS5: Unexpected report len: got %d, want: 78\n", len);
+        uni_hid_parser_ds5_init_report(d);
         return;
     }
 
@@ -583,58 +596,16 @@ void uni_hid_parser_ds5_parse_input_report(uni_hid_device_t* d, const uint8_t* r
     ctl->gamepad.brake = r->brake * 4;
     ctl->gamepad.throttle = r->throttle * 4;
 
-    // Hat
-    uint8_t value = r->buttons[0] & 0xf;
-    if (value > 7)
-        value = 0xff; /* Center 0, 0 */
-    ctl->gamepad.dpad = uni_hid_parser_hat_to_dpad(value);
-
-    // Buttons
-    // TODO: ds4, ds5 have these buttons in common. Refactor.
-    if (r->buttons[0] & 0x10)
-        ctl->gamepad.buttons |= BUTTON_X;  // West
-    if (r->buttons[0] & 0x20)
-        ctl->gamepad.buttons |= BUTTON_A;  // South
-    if (r->buttons[0] & 0x40)
-        ctl->gamepad.buttons |= BUTTON_B;  // East
-    if (r->buttons[0] & 0x80)
-        ctl->gamepad.buttons |= BUTTON_Y;  // North
-    if (r->buttons[1] & 0x01)
-        ctl->gamepad.buttons |= BUTTON_SHOULDER_L;  // L1
-    if (r->buttons[1] & 0x02)
-        ctl->gamepad.buttons |= BUTTON_SHOULDER_R;  // R1
-    if (r->buttons[1] & 0x04)
-        ctl->gamepad.buttons |= BUTTON_TRIGGER_L;  // L2
-    if (r->buttons[1] & 0x08)
-        ctl->gamepad.buttons |= BUTTON_TRIGGER_R;  // R2
-    if (r->buttons[1] & 0x10)
-        ctl->gamepad.misc_buttons |= MISC_BUTTON_SELECT;  // Share
-    if (r->buttons[1] & 0x20)
-        ctl->gamepad.misc_buttons |= MISC_BUTTON_START;  // Options
-    if (r->buttons[1] & 0x40)
-        ctl->gamepad.buttons |= BUTTON_THUMB_L;  // Thumb L
-    if (r->buttons[1] & 0x80)
-        ctl->gamepad.buttons |= BUTTON_THUMB_R;  // Thumb R
-    if (r->buttons[2] & 0x01)
-        ctl->gamepad.misc_buttons |= MISC_BUTTON_SYSTEM;  // PS
-    if (r->buttons[2] & 0x04)
-        ctl->gamepad.misc_buttons |= MISC_BUTTON_CAPTURE;  // "mute" button
+    // Hat + buttons
+    uni_hid_parser_ds_buttons(r->buttons, true, &ctl->gamepad);
 
     // Gyro
-    for (size_t i = 0; i < ARRAY_SIZE(r->gyro); i++) {
-        int32_t raw_data = (int16_t)r->gyro[i];
-        int32_t calib_data =
-            mult_frac(ins->gyro_calib_data[i].sens_numer, raw_data, ins->gyro_calib_data[i].sens_denom);
-        ctl->gamepad.gyro[i] = calib_data;
-    }
+    for (size_t i = 0; i < ARRAY_SIZE(r->gyro); i++)
+        ctl->gamepad.gyro[i] = uni_frac_mul(&ins->gyro_calib_data[i].scale, (int16_t)r->gyro[i]);
 
     // Accel
-    for (size_t i = 0; i < ARRAY_SIZE(r->accel); i++) {
-        int32_t raw_data = (int16_t)r->accel[i];
-        int32_t calib_data =
-            mult_frac(ins->accel_calib_data[i].sens_numer, raw_data, ins->accel_calib_data[i].sens_denom);
-        ctl->gamepad.accel[i] = calib_data;
-    }
+    for (size_t i = 0; i < ARRAY_SIZE(r->accel); i++)
+        ctl->gamepad.accel[i] = uni_frac_mul(&ins->accel_calib_data[i].scale, (int16_t)r->accel[i]);
 
     // Value goes from 0 to 10. Make it from 0 to 250.
     // The +1 is to avoid having a value of 0, which means "battery unavailable".
@@ -734,6 +705,19 @@ static ds5_instance_t* get_ds5_instance(uni_hid_device_t* d) {
     return (ds5_instance_t*)&d->parser_data[0];
 }
 
+// Input reports scale the motion samples with a multiply instead of mult_frac():
+// the divisions are done here, each time the calibration changes.
+static void ds5_update_calibration_scales(ds5_instance_t* ins) {
+    for (size_t i = 0; i < ARRAY_SIZE(ins->gyro_calib_data); i++) {
+        struct ds5_calibration_data* c = &ins->gyro_calib_data[i];
+        uni_frac_init(&c->scale, c->sens_numer, c->sens_denom);
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(ins->accel_calib_data); i++) {
+        struct ds5_calibration_data* c = &ins->accel_calib_data[i];
+        uni_frac_init(&c->scale, c->sens_numer, c->sens_denom);
+    }
+}
+
 static void ds5_send_output_report(uni_hid_device_t* d, ds5_output_report_t* out) {
     ds5_instance_t* ins = get_ds5_instance(d);
 
@@ -888,7 +872,9 @@ static void ds5_send_enable_lightbar_report(uni_hid_device_t* d) {
         // Could happen that the platform rejects the virtual device.
         // E.g: Mouse not supported. If that's the case, break the link
         d->child = NULL;
+        return;
     }
+    uni_hid_parser_ds5_init_report(d);
 }
 
 static void ds5_parse_mouse(uni_hid_device_t* d, const uint8_t* report, uint16_t len) {
@@ -912,6 +898,9 @@ static void ds5_parse_mouse(uni_hid_device_t* d, const uint8_t* report, uint16_t
         ctl->mouse.delta_x = 0;
         ctl->mouse.delta_y = 0;
     }
+    ctl->mouse.buttons = 0;
+    ctl->mouse.scroll_wheel = 0;
+    ctl->mouse.misc_buttons = 0;
 
     // "Click" on Touchpad
     if (r->buttons[2] & 0x02) {
@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "parser/uni_hid_report_map.h"
+
+#include <string.h>
+
+#include "uni_btstack_version_compat.h"
+#include "uni_common.h"
+#include "uni_hid_device.h"
+#include "uni_log.h"
+
+#ifndef HID_REPORT_ID_UNDEFINED
+#define HID_REPORT_ID_UNDEFINED 0xffff
+#endif
+
+#if USE_NEW_PARSER_API
+
+// Array fields report a usage index instead of a value: left to btstack.
+static bool is_variable(const btstack_hid_usage_iterator_t* it) {
+    return (it->descriptor_item.item_value & 2) != 0;
+}
+
+static bool same_globals(const hid_globals_t* a, const hid_globals_t* b) {
+    return a->logical_minimum == b->logical_minimum && a->logical_maximum == b->logical_maximum &&
+           a->usage_page == b->usage_page && a->report_size == b->report_size &&
+           a->report_count == b->report_count && a->report_id == b->report_id;
+}
+
+// Same snapshot uni_hid_parse_input_report() takes before each field.
+static int add_globals(uni_hid_report_map_t* map, const btstack_hid_usage_iterator_t* it) {
+    hid_globals_t g = {
+        .logical_minimum = it->global_logical_minimum,
+        .logical_maximum = it->global_logical_maximum,
+        .usage_page = it->global_usage_page,
+        .report_size = it->global_report_size,
+        .report_count = it->global_report_count,
+        .report_id = it->global_report_id,
+    };
+    // Consecutive fields of a main item share them.
+    if (map->num_globals > 0 && same_globals(&map->globals[map->num_globals - 1], &g))
+        return map->num_globals - 1;
+    if (map->num_globals == UNI_HID_REPORT_MAP_MAX_GLOBALS)
+        return -1;
+    map->globals[map->num_globals] = g;
+    return map->num_globals++;
+}
+
+static bool collect_reports(uni_hid_report_map_t* map, const uint8_t* descriptor, uint16_t descriptor_len) {
+    btstack_hid_usage_iterator_t it;
+    btstack_hid_usage_item_t item;
+    bool has_undefined = false;
+
+    btstack_hid_usage_iterator_init(&it, descriptor, descriptor_len, HID_REPORT_TYPE_INPUT);
+    while (btstack_hid_usage_iterator_has_more(&it)) {
+        btstack_hid_usage_iterator_get_item(&it, &item);
+        if (!is_variable(&it))
+            return false;
+        int i;
+        for (i = 0; i < map->num_reports; i++) {
+            if (map->reports[i].report_id == item.report_id)
+                break;
+        }
+        if (i < map->num_reports)
+            continue;
+        if (map->num_reports == UNI_HID_REPORT_MAP_MAX_REPORTS)
+            return false;
+        map->reports[map->num_reports++].report_id = item.report_id;
+        has_undefined |= item.report_id == HID_REPORT_ID_UNDEFINED;
+    }
+    // Fields without a report ID would have to be merged into every report.
+    return !(has_undefined && map->num_reports > 1);
+}
+
+static bool add_fields(uni_hid_report_map_t* map,
+                       uni_hid_report_entry_t* entry,
+                       const uint8_t* descriptor,
+                       uint16_t descriptor_len) {
+    btstack_hid_usage_iterator_t it;
+    btstack_hid_usage_item_t item;
+
+    entry->first_field = map->num_fields;
+    btstack_hid_usage_iterator_init(&it, descriptor, descriptor_len, HID_REPORT_TYPE_INPUT);
+    while (btstack_hid_usage_iterator_has_more(&it)) {
+        btstack_hid_usage_iterator_get_item(&it, &item);
+        if (item.report_id != entry->report_id)
+            continue;
+        if (map->num_fields == UNI_HID_REPORT_MAP_MAX_FIELDS)
+            return false;
+        int globals_idx = add_globals(map, &it);
+        if (globals_idx < 0)
+            return false;
+        map->fields[map->num_fields++] = (uni_hid_report_field_t){
+            .bit_pos = item.bit_pos,
+            .usage_page = item.usage_page,
+            .usage = item.usage,
+            .size = item.size,
+            .globals_idx = globals_idx,
+        };
+    }
+    entry->num_fields = map->num_fields - entry->first_field;
+    return true;
+}
+
+bool uni_hid_report_map_compile(uni_hid_report_map_t* map, const uint8_t* descriptor, uint16_t descriptor_len) {
+    memset(map, 0, sizeof(*map));
+
+    bool ok = collect_reports(map, descriptor, descriptor_len);
+    for (int i = 0; ok && i < map->num_reports; i++)
+        ok = add_fields(map, &map->reports[i], descriptor, descriptor_len);
+
+    if (!ok) {
+        logd("HID descriptor not compiled, using the HID parser\n");
+        memset(map, 0, sizeof(*map));
+        return false;
+    }
+    map->valid = true;
+    logi("HID descriptor compiled: %d reports, %d fields\n", map->num_reports, map->num_fields);
+    return true;
+}
+
+#else  // !USE_NEW_PARSER_API
+
+bool uni_hid_report_map_compile(uni_hid_report_map_t* map, const uint8_t* descriptor, uint16_t descriptor_len) {
+    ARG_UNUSED(descriptor);
+    ARG_UNUSED(descriptor_len);
+    memset(map, 0, sizeof(*map));
+    return false;
+}
+
+#endif  // !USE_NEW_PARSER_API
+
+// Same extraction as btstack_hid_parser_get_field(), without reading past the
+// report: missing bytes read as zero, where btstack reads the byte after a
+// short report. An unaligned field wider than 25 bits spans 5 bytes, hence the
+// 64-bit accumulator.
+static int32_t read_field(const uni_hid_report_field_t* f,
+                          const hid_globals_t* g,
+                          const uint8_t* report,
+                          uint16_t report_len) {
+    int pos = f->bit_pos >> 3;
+    int last = (f->bit_pos + f->size - 1) >> 3;
+    uint64_t raw = 0;
+    for (int i = 0; pos + i <= last && pos + i < report_len; i++)
+        raw |= (uint64_t)report[pos + i] << (i * 8);
+
+    uint32_t mask = f->size >= 32 ? 0xffffffff : (1u << f->size) - 1;
+    uint32_t value = (uint32_t)(raw >> (f->bit_pos & 0x07)) & mask;
+    if (g->logical_minimum < 0 && (value & (1u << (f->size - 1))))
+        value |= ~mask;
+    return (int32_t)value;
+}
+
+void uni_hid_report_map_parse(const uni_hid_report_map_t* map,
+                              struct uni_hid_device_s* d,
+                              const uint8_t* report,
+                              uint16_t report_len,
+                              report_parse_usage_fn_t parse_usage) {
+    const uni_hid_report_entry_t* entry = NULL;
+    for (int i = 0; i < map->num_reports; i++) {
+        const uni_hid_report_entry_t* e = &map->reports[i];
+        if (e->report_id == HID_REPORT_ID_UNDEFINED || (report_len > 0 && e->report_id == report[0])) {
+            entry = e;
+            break;
+        }
+    }
+    if (entry == NULL)
+        return;
+
+    const uni_hid_report_field_t* f = &map->fields[entry->first_field];
+    const uni_hid_report_field_t* end = f + entry->num_fields;
+    for (; f < end; f++) {
+        const hid_globals_t* g = &map->globals[f->globals_idx];
+        parse_usage(d, g, f->usage_page, f->usage, read_field(f, g, report, report_len));
+    }
+}
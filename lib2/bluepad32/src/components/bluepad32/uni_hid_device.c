@@ -387,9 +387,10 @@ void uni_hid_device_set_hid_descriptor(uni_hid_device_t* d, const uint8_t* descr
     }
 
     int min = btstack_min(HID_MAX_DESCRIPTOR_LEN, len);
-    memcpy(d->hid_descriptor, descriptor, len);
+    memcpy(d->hid_descriptor, descriptor, min);
     d->hid_descriptor_len = min;
     d->flags |= FLAGS_HAS_HID_DESCRIPTOR;
+    uni_hid_report_map_compile(&d->report_map, d->hid_descriptor, d->hid_descriptor_len);
 
     //    printf_hexdump(descriptor, len);
 }
@@ -502,6 +503,7 @@ void uni_hid_device_delete(uni_hid_device_t* d) {
 
     // Remove the timer. If it was still running, it will crash if the handler gets called.
     btstack_run_loop_remove_timer(&d->connection_timer);
+    uni_output_queue_reset(&d->output_queue);
 
     uni_hid_device_init(d);
 }
@@ -668,8 +670,8 @@ void uni_hid_device_guess_controller_type_from_pid_vid(uni_hid_device_t* d) {
             logi("Device detected as DualShock 3: 0x%02x\n", type);
             break;
         case CONTROLLER_TYPE_PS4Controller:
+            // No init_report: the parser overwrites the whole controller state on each report.
             d->report_parser.setup = uni_hid_parser_ds4_setup;
-            d->report_parser.init_report = uni_hid_parser_ds4_init_report;
             d->report_parser.parse_input_report = uni_hid_parser_ds4_parse_input_report;
             d->report_parser.parse_feature_report = uni_hid_parser_ds4_parse_feature_report;
             d->report_parser.set_lightbar_color = uni_hid_parser_ds4_set_lightbar_color;
@@ -678,7 +680,7 @@ void uni_hid_device_guess_controller_type_from_pid_vid(uni_hid_device_t* d) {
             logi("Device detected as DualShock 4: 0x%02x\n", type);
             break;
         case CONTROLLER_TYPE_PS5Controller:
-            d->report_parser.init_report = uni_hid_parser_ds5_init_report;
+            // No init_report: the parser overwrites the whole controller state on each report.
             d->report_parser.setup = uni_hid_parser_ds5_setup;
             d->report_parser.parse_input_report = uni_hid_parser_ds5_parse_input_report;
             d->report_parser.parse_feature_report = uni_hid_parser_ds5_parse_feature_report;
@@ -757,6 +759,18 @@ void uni_hid_device_guess_controller_type_from_pid_vid(uni_hid_device_t* d) {
     d->flags |= FLAGS_HAS_CONTROLLER_TYPE;
 }
 
+void uni_hid_device_clear_controller_type(uni_hid_device_t* d) {
+    if (d == NULL) {
+        loge("ERROR: Invalid device\n");
+        return;
+    }
+
+    d->controller_type = CONTROLLER_TYPE_Unknown;
+    d->controller_subtype = CONTROLLER_SUBTYPE_NONE;
+    memset(&d->report_parser, 0, sizeof(d->report_parser));
+    d->flags &= ~FLAGS_HAS_CONTROLLER_TYPE;
+}
+
 bool uni_hid_device_has_controller_type(const uni_hid_device_t* d) {
     if (d == NULL) {
         loge("ERROR: Invalid device\n");
@@ -787,14 +801,18 @@ void uni_hid_device_process_controller(uni_hid_device_t* d) {
         // Deprecated: should implement only on_controller_data
         uni_get_platform()->on_gamepad_data(d, &d->controller.gamepad);
 
+    uni_hid_device_process_misc_buttons(d);
+}
+
+// For platforms that consume raw reports: d->controller.gamepad.misc_buttons
+// has to be set by the caller.
+void uni_hid_device_process_misc_buttons(uni_hid_device_t* d) {
     // FIXME: each backend should decide what to do with misc buttons
     process_misc_button_system(d);
     process_misc_button_home(d);
 }
 
-// Try to send the report now. If it can't, queue it and send it in the next
-// event loop.
-void uni_hid_device_send_report(uni_hid_device_t* d, uint16_t cid, const uint8_t* report, uint16_t len) {
+static void send_report(uni_hid_device_t* d, uint16_t cid, const uint8_t* report, uint16_t len, bool replaceable) {
     if (d == NULL) {
         loge("Send report: Invalid device\n");
         return;
@@ -809,16 +827,13 @@ void uni_hid_device_send_report(uni_hid_device_t* d, uint16_t cid, const uint8_t
         return;
     }
 
-    int err = l2cap_send(cid, (uint8_t*)report, len);
-    if (err != 0) {
-        logd("Could not send report (error=0x%04x). Adding it to queue\n", err);
-        if (uni_circular_buffer_put(&d->outgoing_buffer, cid, report, len) != 0) {
-            loge("ERROR: circular buffer full. Cannot queue report\n");
-        }
-    }
-    // Even, if it can send the report, trigger a "can send now event" in case a report was queued.
-    // TODO: Is this really needed?
-    l2cap_request_can_send_now_event(cid);
+    uni_output_queue_send(&d->output_queue, cid, report, len, replaceable);
+}
+
+// Try to send the report now. If it can't, queue it and send it when L2CAP
+// says it can.
+void uni_hid_device_send_report(uni_hid_device_t* d, uint16_t cid, const uint8_t* report, uint16_t len) {
+    send_report(d, cid, report, len, false);
 }
 
 // Sends an interrupt-report. If it can't, it will queue it and try again later.
@@ -827,7 +842,18 @@ void uni_hid_device_send_intr_report(uni_hid_device_t* d, const uint8_t* report,
         loge("Invalid device\n");
         return;
     }
-    uni_hid_device_send_report(d, d->conn.interrupt_cid, report, len);
+    send_report(d, d->conn.interrupt_cid, report, len, false);
+}
+
+// Like uni_hid_device_send_intr_report(), for reports that carry the complete
+// output state (rumble, LEDs...): if one with the same report id is still
+// queued, it is replaced instead of queuing another one.
+void uni_hid_device_send_intr_report_latest(uni_hid_device_t* d, const uint8_t* report, uint16_t len) {
+    if (d == NULL) {
+        loge("Invalid device\n");
+        return;
+    }
+    send_report(d, d->conn.interrupt_cid, report, len, true);
 }
 
 // Queue a control-report and send it the report in the next event loop.
@@ -840,26 +866,14 @@ void uni_hid_device_send_ctrl_report(uni_hid_device_t* d, const uint8_t* report,
     uni_hid_device_send_report(d, d->conn.control_cid, report, len);
 }
 
-// Send the reports that are already queued. Uses the "intr" channel.
+// Send the reports that are already queued, as many as the link takes.
 void uni_hid_device_send_queued_reports(uni_hid_device_t* d) {
     if (d == NULL) {
         loge("Invalid device\n");
         return;
     }
 
-    if (uni_circular_buffer_is_empty(&d->outgoing_buffer)) {
-        logd("circular buffer empty?\n");
-        return;
-    }
-
-    void* data;
-    int data_len;
-    int16_t cid;
-    if (uni_circular_buffer_get(&d->outgoing_buffer, &cid, &data, &data_len) != UNI_CIRCULAR_BUFFER_ERROR_OK) {
-        loge("ERROR: could not get buffer from circular buffer.\n");
-        return;
-    }
-    uni_hid_device_send_report(d, cid, data, data_len);
+    uni_output_queue_flush(&d->output_queue);
 }
 
 bool uni_hid_device_does_require_hid_descriptor(const uni_hid_device_t* d) {
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "uni_output_queue.h"
+
+#include <string.h>
+
+#include "uni_log.h"
+
+static uni_output_queue_stats_t stats;
+
+static void refill(uni_output_queue_t* q, uint32_t now_ms) {
+    if (q->tokens_used == 0)
+        return;
+    uint32_t n = (now_ms - q->refill_ms) / UNI_OUTPUT_QUEUE_REFILL_MS;
+    if (n >= q->tokens_used) {
+        q->tokens_used = 0;
+    } else {
+        q->tokens_used -= n;
+        q->refill_ms += n * UNI_OUTPUT_QUEUE_REFILL_MS;
+    }
+}
+
+static bool take_token(uni_output_queue_t* q, uint32_t now_ms) {
+    refill(q, now_ms);
+    if (q->tokens_used >= UNI_OUTPUT_QUEUE_BURST)
+        return false;
+    if (q->tokens_used == 0)
+        q->refill_ms = now_ms;
+    q->tokens_used++;
+    return true;
+}
+
+static void on_pace_timer(btstack_timer_source_t* ts) {
+    uni_output_queue_t* q = btstack_run_loop_get_timer_context(ts);
+    q->pace_timer_armed = false;
+    uni_output_queue_flush(q);
+}
+
+static void arm_pace_timer(uni_output_queue_t* q, uint32_t now_ms) {
+    if (q->pace_timer_armed)
+        return;
+    stats.deferred++;
+    uint32_t wait_ms = UNI_OUTPUT_QUEUE_REFILL_MS - (now_ms - q->refill_ms);
+    btstack_run_loop_set_timer_handler(&q->pace_timer, on_pace_timer);
+    btstack_run_loop_set_timer_context(&q->pace_timer, q);
+    btstack_run_loop_set_timer(&q->pace_timer, wait_ms);
+    btstack_run_loop_add_timer(&q->pace_timer);
+    q->pace_timer_armed = true;
+}
+
+static uni_output_queue_entry_t* find_replaceable(uni_output_queue_t* q,
+                                                  uint16_t cid,
+                                                  const uint8_t* report,
+                                                  uint16_t len) {
+    for (int i = 0; i < q->count; i++) {
+        uni_output_queue_entry_t* e = &q->entries[(q->head + i) % UNI_OUTPUT_QUEUE_SIZE];
+        // Same channel, same HID transaction header and report id.
+        if (e->replaceable && e->cid == cid && e->len == len && len >= 2 && e->data[0] == report[0] &&
+            e->data[1] == report[1])
+            return e;
+    }
+    return NULL;
+}
+
+void uni_output_queue_send(uni_output_queue_t* q, uint16_t cid, const uint8_t* report, uint16_t len, bool replaceable) {
+    uint32_t now_ms = btstack_run_loop_get_time_ms();
+
+    // Fast path: nothing ahead of it, send it without copying.
+    if (q->count == 0 && l2cap_can_send_packet_now(cid)) {
+        if (!take_token(q, now_ms)) {
+            arm_pace_timer(q, now_ms);
+        } else if (l2cap_send(cid, (uint8_t*)report, len) == ERROR_CODE_SUCCESS) {
+            stats.sent++;
+            return;
+        }
+    }
+
+    if (replaceable) {
+        uni_output_queue_entry_t* e = find_replaceable(q, cid, report, len);
+        if (e != NULL) {
+            memcpy(e->data, report, len);
+            stats.merged++;
+            return;
+        }
+    }
+
+    if (len > UNI_OUTPUT_QUEUE_DATA_SIZE) {
+        loge("Output queue: report too big (%d bytes)\n", len);
+        stats.dropped++;
+        return;
+    }
+    if (q->count == UNI_OUTPUT_QUEUE_SIZE) {
+        loge("Output queue: full. Cannot queue report\n");
+        stats.dropped++;
+        return;
+    }
+
+    uni_output_queue_entry_t* e = &q->entries[(q->head + q->count) % UNI_OUTPUT_QUEUE_SIZE];
+    e->cid = cid;
+    e->len = len;
+    e->replaceable = replaceable;
+    memcpy(e->data, report, len);
+    q->count++;
+    if (q->count > q->max_count)
+        q->max_count = q->count;
+
+    uni_output_queue_flush(q);
+}
+
+void uni_output_queue_flush(uni_output_queue_t* q) {
+    while (q->count > 0 && !q->pace_timer_armed) {
+        uni_output_queue_entry_t* e = &q->entries[q->head];
+        if (!l2cap_can_send_packet_now(e->cid)) {
+            // Drained again from L2CAP_EVENT_CAN_SEND_NOW.
+            l2cap_request_can_send_now_event(e->cid);
+            return;
+        }
+        uint32_t now_ms = btstack_run_loop_get_time_ms();
+        if (!take_token(q, now_ms)) {
+            arm_pace_timer(q, now_ms);
+            return;
+        }
+        uint8_t err = l2cap_send(e->cid, e->data, e->len);
+        if (err != ERROR_CODE_SUCCESS) {
+            logd("Output queue: could not send report (error=0x%04x)\n", err);
+            l2cap_request_can_send_now_event(e->cid);
+            return;
+        }
+        stats.sent++;
+        q->head = (q->head + 1) % UNI_OUTPUT_QUEUE_SIZE;
+        q->count--;
+    }
+}
+
+void uni_output_queue_reset(uni_output_queue_t* q) {
+    if (q->pace_timer_armed)
+        btstack_run_loop_remove_timer(&q->pace_timer);
+    memset(q, 0, sizeof(*q));
+}
+
+uint8_t uni_output_queue_get_depth(const uni_output_queue_t* q) {
+    return q->count;
+}
+
+bool uni_output_queue_is_empty(const uni_output_queue_t* q) {
+    return q->count == 0;
+}
+
+const uni_output_queue_stats_t* uni_output_queue_get_stats(void) {
+    return &stats;
+}
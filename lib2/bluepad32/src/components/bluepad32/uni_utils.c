@@ -4,9 +4,38 @@
 
 #include "uni_utils.h"
 
+#include <stdbool.h>
+#include <string.h>
+
 #define CRCPOLY 0xedb88320
 
+// Slice-by-4 tables, built on first use: 4 KiB of RAM.
+static uint32_t crc_table[4][256];
+static bool crc_table_ready;
+static uni_crc32_fn_t crc_engine = uni_crc32_le_table;
+
+static void crc_table_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c >> 1) ^ ((c & 1) ? CRCPOLY : 0);
+        crc_table[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = crc_table[0][i];
+        for (int t = 1; t < 4; t++) {
+            c = crc_table[0][c & 0xff] ^ (c >> 8);
+            crc_table[t][i] = c;
+        }
+    }
+    crc_table_ready = true;
+}
+
 uint32_t uni_crc32_le(uint32_t crc, const uint8_t* data, size_t len) {
+    return crc_engine(crc, data, len);
+}
+
+uint32_t uni_crc32_le_bitwise(uint32_t crc, const uint8_t* data, size_t len) {
     uint32_t mult;
     int i;
 
@@ -20,3 +49,36 @@ uint32_t uni_crc32_le(uint32_t crc, const uint8_t* data, size_t len) {
 
     return crc;
 }
+
+uint32_t uni_crc32_le_table(uint32_t crc, const uint8_t* data, size_t len) {
+    if (!crc_table_ready)
+        crc_table_init();
+
+    // Assumes a little-endian CPU, like every supported target.
+    while (len >= 4) {
+        uint32_t word;
+        memcpy(&word, data, sizeof(word));
+        crc ^= word;
+        crc = crc_table[3][crc & 0xff] ^ crc_table[2][(crc >> 8) & 0xff] ^ crc_table[1][(crc >> 16) & 0xff] ^
+              crc_table[0][crc >> 24];
+        data += 4;
+        len -= 4;
+    }
+    while (len--)
+        crc = crc_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+
+    return crc;
+}
+
+void uni_crc32_set_engine(uni_crc32_fn_t fn) {
+    crc_engine = fn ? fn : uni_crc32_le_table;
+}
+
+void uni_frac_init(uni_frac_t* f, int32_t multiplier, int32_t divisor) {
+    uint32_t m = multiplier < 0 ? -(uint32_t)multiplier : (uint32_t)multiplier;
+    uint32_t d = divisor < 0 ? -(uint32_t)divisor : (uint32_t)divisor;
+
+    f->quot = m / d;
+    f->frac = (uint32_t)((((uint64_t)(m % d) << 32) + d - 1) / d);
+    f->negative = (multiplier < 0) != (divisor < 0);
+}
@@ -0,0 +1,99 @@
+#include "link_loss.h"
+
+#define HOLD_US (LINK_LOSS_HOLD_MS * 1000u)
+#define DECAY_US (LINK_LOSS_DECAY_MS * 1000u)
+#define DECAY_STEP_US (LINK_LOSS_DECAY_STEP_MS * 1000u)
+
+static struct {
+  link_loss_state_t state;
+  ds4_report_t last;
+  uint32_t last_frame_us;
+  uint32_t lost_us;       // when the timeout expired
+  uint32_t last_step_us;  // last decay report accepted
+  bool stepped;
+} link = {.state = LINK_LOSS_NEUTRAL};
+
+static uint8_t ease_axis(uint8_t value, uint8_t neutral, uint32_t scale) {
+  int32_t delta = (int32_t)value - neutral;
+  return (uint8_t)(neutral + delta * (int32_t)scale / 256);
+}
+
+// Neutral report with the sticks and triggers of the last one, scaled towards
+// neutral by scale / 256.
+static void decay_report(uint32_t scale, ds4_report_t* out) {
+  *out = default_ds4_report();
+  out->left_stick_x = ease_axis(link.last.left_stick_x, DS4_JOYSTICK_MID, scale);
+  out->left_stick_y = ease_axis(link.last.left_stick_y, DS4_JOYSTICK_MID, scale);
+  out->right_stick_x = ease_axis(link.last.right_stick_x, DS4_JOYSTICK_MID, scale);
+  out->right_stick_y = ease_axis(link.last.right_stick_y, DS4_JOYSTICK_MID, scale);
+  out->left_trigger = ease_axis(link.last.left_trigger, 0, scale);
+  out->right_trigger = ease_axis(link.last.right_trigger, 0, scale);
+}
+
+void link_loss_on_frame(const ds4_report_t* report, uint32_t now_us) {
+  link.last = *report;
+  link.last_frame_us = now_us;
+  link.state = LINK_LOSS_LIVE;
+}
+
+bool link_loss_poll(uint32_t now_us, uint32_t timeout_us, ds4_report_t* out) {
+  if (link.state == LINK_LOSS_LIVE) {
+    if (now_us - link.last_frame_us <= timeout_us) {
+      return false;
+    }
+    link.lost_us = now_us;
+    link.stepped = false;
+    switch (LINK_LOSS_POLICY) {
+      case LINK_LOSS_POLICY_HOLD:
+        link.state = LINK_LOSS_HOLDING;
+        break;
+      case LINK_LOSS_POLICY_DECAY:
+        link.state = LINK_LOSS_DECAYING;
+        break;
+      default:
+        link.state = LINK_LOSS_NEUTRAL_PENDING;
+        break;
+    }
+  }
+
+  uint32_t lost_for_us = now_us - link.lost_us;
+  switch (link.state) {
+    case LINK_LOSS_HOLDING:
+      if (lost_for_us < HOLD_US) {
+        return false;
+      }
+      link.state = LINK_LOSS_NEUTRAL_PENDING;
+      break;
+    case LINK_LOSS_DECAYING:
+      if (lost_for_us >= DECAY_US) {
+        link.state = LINK_LOSS_NEUTRAL_PENDING;
+        break;
+      }
+      if (link.stepped && now_us - link.last_step_us < DECAY_STEP_US) {
+        return false;
+      }
+      decay_report((DECAY_US - lost_for_us) * 256u / DECAY_US, out);
+      return true;
+    default:
+      break;
+  }
+
+  if (link.state != LINK_LOSS_NEUTRAL_PENDING) {
+    return false;
+  }
+  *out = default_ds4_report();
+  return true;
+}
+
+void link_loss_on_sent(uint32_t now_us) {
+  if (link.state == LINK_LOSS_DECAYING) {
+    link.last_step_us = now_us;
+    link.stepped = true;
+  } else if (link.state == LINK_LOSS_NEUTRAL_PENDING) {
+    link.state = LINK_LOSS_NEUTRAL;
+  }
+}
+
+link_loss_state_t link_loss_get_state(void) {
+  return link.state;
+}
@@ -0,0 +1,68 @@
+#ifndef LINK_LOSS_H_
+#define LINK_LOSS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dualshock4.h"
+
+/*
+ * Link loss handling
+ * ------------------
+ * When no frame has been forwarded for the update timeout (main.c, derived
+ * from the measured Bluetooth report rate), the link is considered lost and
+ * the host is moved to the neutral report according to LINK_LOSS_POLICY:
+ *
+ *   NEUTRAL  neutral report right away.
+ *   HOLD     nothing is sent for LINK_LOSS_HOLD_MS, so the host keeps the
+ *            last input; neutral afterwards. A radio glitch shorter than
+ *            timeout + hold is invisible to the host.
+ *   DECAY    buttons are released right away and sticks and triggers ease
+ *            to neutral over LINK_LOSS_DECAY_MS, one report every
+ *            LINK_LOSS_DECAY_STEP_MS.
+ *
+ * A new frame ends the episode at any point. Nothing here blocks: the USB
+ * loop calls link_loss_poll() on every pass where it had no frame to send and
+ * keeps servicing tud_task() in between.
+ *
+ * All functions run on core0.
+ */
+
+typedef enum {
+  LINK_LOSS_POLICY_NEUTRAL = 0,
+  LINK_LOSS_POLICY_HOLD,
+  LINK_LOSS_POLICY_DECAY,
+} link_loss_policy_t;
+
+#ifndef LINK_LOSS_POLICY
+#define LINK_LOSS_POLICY LINK_LOSS_POLICY_HOLD
+#endif
+#ifndef LINK_LOSS_HOLD_MS
+#define LINK_LOSS_HOLD_MS 100
+#endif
+#ifndef LINK_LOSS_DECAY_MS
+#define LINK_LOSS_DECAY_MS 150
+#endif
+#ifndef LINK_LOSS_DECAY_STEP_MS
+#define LINK_LOSS_DECAY_STEP_MS 8
+#endif
+
+typedef enum {
+  LINK_LOSS_LIVE = 0,         // frames arrive
+  LINK_LOSS_HOLDING,          // lost, host keeps the last input
+  LINK_LOSS_DECAYING,         // lost, easing to neutral
+  LINK_LOSS_NEUTRAL_PENDING,  // lost, neutral report not accepted yet
+  LINK_LOSS_NEUTRAL,          // lost, host has the neutral report
+} link_loss_state_t;
+
+// A frame was forwarded to the host.
+void link_loss_on_frame(const ds4_report_t* report, uint32_t now_us);
+
+// No frame this pass. Returns true, with the report in *out, when a report has
+// to be sent now; call link_loss_on_sent() once the USB stack accepted it.
+bool link_loss_poll(uint32_t now_us, uint32_t timeout_us, ds4_report_t* out);
+void link_loss_on_sent(uint32_t now_us);
+
+link_loss_state_t link_loss_get_state(void);
+
+#endif  // LINK_LOSS_H_
@@ -0,0 +1,242 @@
+#include "link_policy.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "debug.h"
+#include "dualshock4.h"
+
+// Commands BTstack has no definition for.
+static const hci_cmd_t link_flow_specification = {HCI_OPCODE(OGF_LINK_POLICY, 0x10), "H1114444"};
+static const hci_cmd_t link_read_automatic_flush_timeout = {HCI_OPCODE(OGF_CONTROLLER_BASEBAND, 0x27), "H"};
+static const hci_cmd_t link_write_automatic_flush_timeout = {HCI_OPCODE(OGF_CONTROLLER_BASEBAND, 0x28), "H2"};
+static const hci_cmd_t link_read_link_policy_settings = {HCI_OPCODE(OGF_LINK_POLICY, 0x0c), "H"};
+
+#ifndef HCI_EVENT_FLOW_SPECIFICATION_COMPLETE
+#define HCI_EVENT_FLOW_SPECIFICATION_COMPLETE 0x21
+#endif
+#define FLOW_DIRECTION_INCOMING 0x01
+#define SERVICE_TYPE_GUARANTEED 0x02
+#define LINK_MODE_SNIFF 0x02
+
+// Dead zones for "the controller is in use".
+#define RAW_STICK_DEADZONE 24      // around 0x80, of 0..255
+#define RAW_TRIGGER_DEADZONE 16    // of 0..255
+#define GAMEPAD_STICK_DEADZONE 96  // of -512..511
+#define GAMEPAD_TRIGGER_DEADZONE 64
+
+#define IDLE_CHECK_MS 1000
+
+typedef enum {
+  STEP_WRITE_LINK_POLICY,
+  STEP_EXIT_SNIFF,
+  STEP_FLOW_SPECIFICATION,
+  STEP_WRITE_FLUSH_TIMEOUT,
+  STEP_ENTER_SNIFF,
+  STEP_READ_LINK_POLICY,
+  STEP_READ_FLUSH_TIMEOUT,
+  STEP_DONE,
+} link_step_t;
+
+static const link_step_t streaming_steps[] = {
+    STEP_WRITE_LINK_POLICY,  STEP_EXIT_SNIFF,       STEP_FLOW_SPECIFICATION,
+    STEP_WRITE_FLUSH_TIMEOUT, STEP_READ_LINK_POLICY, STEP_READ_FLUSH_TIMEOUT,
+    STEP_DONE,
+};
+
+static const link_step_t relaxed_steps[] = {
+    STEP_WRITE_LINK_POLICY, STEP_WRITE_FLUSH_TIMEOUT, STEP_ENTER_SNIFF,
+    STEP_READ_LINK_POLICY,  STEP_READ_FLUSH_TIMEOUT,  STEP_DONE,
+};
+
+static struct {
+  hci_con_handle_t handle;
+  link_profile_t profile;
+  const link_step_t* steps;
+  uint8_t step_idx;
+  bool sniffing;
+  uint32_t last_active_ms;
+} link = {.handle = HCI_CON_HANDLE_INVALID};
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static btstack_timer_source_t idle_timer;
+
+static uint8_t link_send_step(link_step_t step) {
+  bool streaming = link.profile == LINK_PROFILE_STREAMING;
+
+  switch (step) {
+    case STEP_WRITE_LINK_POLICY:
+      return hci_send_cmd(&hci_write_link_policy_settings, link.handle,
+                          streaming ? LM_LINK_POLICY_ENABLE_ROLE_SWITCH
+                                    : LM_LINK_POLICY_ENABLE_SNIFF_MODE | LM_LINK_POLICY_ENABLE_ROLE_SWITCH);
+    case STEP_EXIT_SNIFF:
+      return hci_send_cmd(&hci_exit_sniff_mode, link.handle);
+    case STEP_FLOW_SPECIFICATION:
+      // Token bucket size 0: no burst requirement. Peak bandwidth 0: unknown.
+      return hci_send_cmd(&link_flow_specification, link.handle, 0, FLOW_DIRECTION_INCOMING, SERVICE_TYPE_GUARANTEED,
+                          LINK_POLICY_TOKEN_RATE, 0, 0, LINK_POLICY_ACCESS_LATENCY_US);
+    case STEP_WRITE_FLUSH_TIMEOUT:
+      // 0 is "never flush", the controller default.
+      return hci_send_cmd(&link_write_automatic_flush_timeout, link.handle,
+                          streaming ? LINK_POLICY_FLUSH_TIMEOUT_SLOTS : 0);
+    case STEP_ENTER_SNIFF:
+      return hci_send_cmd(&hci_sniff_mode, link.handle, LINK_POLICY_SNIFF_MAX_SLOTS, LINK_POLICY_SNIFF_MIN_SLOTS,
+                          LINK_POLICY_SNIFF_ATTEMPT, LINK_POLICY_SNIFF_TIMEOUT);
+    case STEP_READ_LINK_POLICY:
+      return hci_send_cmd(&link_read_link_policy_settings, link.handle);
+    case STEP_READ_FLUSH_TIMEOUT:
+      return hci_send_cmd(&link_read_automatic_flush_timeout, link.handle);
+    default:
+      return ERROR_CODE_SUCCESS;
+  }
+}
+
+// Sends the next command of the current profile, one per HCI command slot.
+static void link_run(void) {
+  if (link.steps == NULL || link.handle == HCI_CON_HANDLE_INVALID) {
+    return;
+  }
+
+  while (link.steps[link.step_idx] != STEP_DONE) {
+    link_step_t step = link.steps[link.step_idx];
+    if (step == STEP_EXIT_SNIFF && !link.sniffing) {
+      link.step_idx++;
+      continue;
+    }
+    if (!hci_can_send_command_packet_now()) {
+      // Retried on the next HCI event.
+      return;
+    }
+    uint8_t status = link_send_step(step);
+    if (status != ERROR_CODE_SUCCESS) {
+      PICO_ERROR("Link policy: step %d failed, status=0x%02x\n", step, status);
+    }
+    link.step_idx++;
+    return;
+  }
+  link.steps = NULL;
+}
+
+static void link_apply(link_profile_t profile) {
+  link.profile = profile;
+  link.steps = profile == LINK_PROFILE_STREAMING ? streaming_steps : relaxed_steps;
+  link.step_idx = 0;
+  PICO_INFO("Link profile: %s\n", profile == LINK_PROFILE_STREAMING ? "streaming" : "relaxed");
+  link_run();
+}
+
+static void link_log_event(const uint8_t* packet) {
+  switch (hci_event_packet_get_type(packet)) {
+    case HCI_EVENT_MODE_CHANGE:
+      if (little_endian_read_16(packet, 3) == link.handle && packet[2] == ERROR_CODE_SUCCESS) {
+        link.sniffing = packet[5] == LINK_MODE_SNIFF;
+        PICO_INFO("Link mode: %s, interval %u slots\n", link.sniffing ? "sniff" : "active",
+                  little_endian_read_16(packet, 6));
+      }
+      break;
+    case HCI_EVENT_FLOW_SPECIFICATION_COMPLETE:
+      if (little_endian_read_16(packet, 3) == link.handle) {
+        PICO_INFO("Link flow spec: status 0x%02x, service %u, token rate %u B/s, access latency %u us\n", packet[2],
+                  packet[7], little_endian_read_32(packet, 8), little_endian_read_32(packet, 20));
+      }
+      break;
+    case HCI_EVENT_COMMAND_COMPLETE: {
+      uint16_t opcode = hci_event_command_complete_get_command_opcode(packet);
+      if (opcode == link_read_link_policy_settings.opcode && packet[5] == ERROR_CODE_SUCCESS) {
+        PICO_INFO("Link policy settings: 0x%04x\n", little_endian_read_16(packet, 8));
+      } else if (opcode == link_read_automatic_flush_timeout.opcode && packet[5] == ERROR_CODE_SUCCESS) {
+        PICO_INFO("Link flush timeout: %u slots\n", little_endian_read_16(packet, 8));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+static void link_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packet, uint16_t size) {
+  (void)channel;
+  (void)size;
+
+  if (packet_type != HCI_EVENT_PACKET) {
+    return;
+  }
+  link_log_event(packet);
+  // Every event may have freed the HCI command slot.
+  link_run();
+}
+
+static void link_idle_check(btstack_timer_source_t* ts) {
+  if (link.profile == LINK_PROFILE_STREAMING &&
+      btstack_run_loop_get_time_ms() - link.last_active_ms >= LINK_POLICY_IDLE_MS) {
+    link_apply(LINK_PROFILE_RELAXED);
+  }
+  if (link.profile != LINK_PROFILE_NONE) {
+    btstack_run_loop_set_timer(ts, IDLE_CHECK_MS);
+    btstack_run_loop_add_timer(ts);
+  }
+}
+
+static bool link_frame_is_active(const ds4_frame_t* frame) {
+  if (frame->mode == DS4_BRIDGE_MODE_PASSTHROUGH) {
+    const ds4_report_t* r = (const ds4_report_t*)frame->raw;
+    const uint8_t sticks[] = {r->left_stick_x, r->left_stick_y, r->right_stick_x, r->right_stick_y};
+    for (size_t i = 0; i < sizeof(sticks); i++) {
+      if (abs(sticks[i] - 0x80) > RAW_STICK_DEADZONE) {
+        return true;
+      }
+    }
+    // Everything in the first button bytes but the d-pad hat (0x8 = centre)
+    // and the report counter.
+    const uint8_t* buttons = &frame->raw[offsetof(ds4_report_t, right_stick_y) + 1];
+    return (buttons[0] & 0x0f) != 0x08 || (buttons[0] & 0xf0) || buttons[1] || (buttons[2] & 0x03) ||
+           r->left_trigger > RAW_TRIGGER_DEADZONE || r->right_trigger > RAW_TRIGGER_DEADZONE;
+  }
+
+  const uni_gamepad_t* gp = &frame->gamepad;
+  return gp->dpad || gp->buttons || gp->misc_buttons || abs(gp->axis_x) > GAMEPAD_STICK_DEADZONE ||
+         abs(gp->axis_y) > GAMEPAD_STICK_DEADZONE || abs(gp->axis_rx) > GAMEPAD_STICK_DEADZONE ||
+         abs(gp->axis_ry) > GAMEPAD_STICK_DEADZONE || gp->brake > GAMEPAD_TRIGGER_DEADZONE ||
+         gp->throttle > GAMEPAD_TRIGGER_DEADZONE;
+}
+
+void link_policy_init(void) {
+  hci_event_callback_registration.callback = &link_packet_handler;
+  hci_add_event_handler(&hci_event_callback_registration);
+  btstack_run_loop_set_timer_handler(&idle_timer, &link_idle_check);
+}
+
+void link_policy_on_connected(hci_con_handle_t handle) {
+  link.handle = handle;
+  link.sniffing = false;
+  link.last_active_ms = btstack_run_loop_get_time_ms();
+  link_apply(LINK_PROFILE_STREAMING);
+
+  btstack_run_loop_remove_timer(&idle_timer);
+  btstack_run_loop_set_timer(&idle_timer, IDLE_CHECK_MS);
+  btstack_run_loop_add_timer(&idle_timer);
+}
+
+void link_policy_on_disconnected(hci_con_handle_t handle) {
+  if (handle != link.handle) {
+    return;
+  }
+  btstack_run_loop_remove_timer(&idle_timer);
+  link.handle = HCI_CON_HANDLE_INVALID;
+  link.profile = LINK_PROFILE_NONE;
+  link.steps = NULL;
+}
+
+void link_policy_on_frame(const ds4_frame_t* frame) {
+  if (link.profile == LINK_PROFILE_NONE || !link_frame_is_active(frame)) {
+    return;
+  }
+  link.last_active_ms = btstack_run_loop_get_time_ms();
+  if (link.profile == LINK_PROFILE_RELAXED) {
+    link_apply(LINK_PROFILE_STREAMING);
+  }
+}
+
+link_profile_t link_policy_get_profile(void) {
+  return link.profile;
+}
@@ -0,0 +1,61 @@
+#ifndef LINK_POLICY_H_
+#define LINK_POLICY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <btstack.h>
+
+#include "comm.h"
+
+/*
+ * Bluetooth link profiles
+ * -----------------------
+ * Bluepad32 allows sniff mode on every link, so a controller can ask for
+ * sniff intervals that add tens of milliseconds of latency and jitter.
+ * Once a BR/EDR controller is connected the link is switched to a streaming
+ * profile:
+ *
+ *   - sniff disabled in the link policy, and left if already active
+ *   - flow specification for the incoming (controller -> bridge) traffic,
+ *     guaranteed service with a short access latency
+ *   - automatic flush timeout on our outgoing packets (rumble / lightbar),
+ *     so a stale output report is dropped instead of delaying newer ones
+ *
+ * When no button, trigger or stick has moved for LINK_POLICY_IDLE_MS, the link
+ * falls back to a relaxed profile (sniff allowed and requested, no flush
+ * timeout) to save power. The first input out of the dead zone switches it
+ * back. The resulting link parameters are logged as the controller reports
+ * them.
+ *
+ * All functions run on core1 (BTstack run loop).
+ */
+
+#define LINK_POLICY_IDLE_MS 20000           // untouched this long -> relaxed profile
+#define LINK_POLICY_FLUSH_TIMEOUT_SLOTS 16  // 10ms in 0.625ms slots
+#define LINK_POLICY_ACCESS_LATENCY_US 1250  // requested for the incoming flow
+#define LINK_POLICY_TOKEN_RATE 80000        // bytes/s: 78-byte DS4 reports at 1 kHz
+#define LINK_POLICY_SNIFF_MIN_SLOTS 16      // relaxed profile: 10ms..20ms sniff interval
+#define LINK_POLICY_SNIFF_MAX_SLOTS 32
+#define LINK_POLICY_SNIFF_ATTEMPT 2
+#define LINK_POLICY_SNIFF_TIMEOUT 1
+
+typedef enum {
+  LINK_PROFILE_NONE = 0,  // not connected
+  LINK_PROFILE_STREAMING,
+  LINK_PROFILE_RELAXED,
+} link_profile_t;
+
+// Registers for HCI events. Call once after uni_init().
+void link_policy_init(void);
+
+// Applies the streaming profile to a newly connected BR/EDR controller.
+void link_policy_on_connected(hci_con_handle_t handle);
+void link_policy_on_disconnected(hci_con_handle_t handle);
+
+// Called with every published frame to track whether the controller is in use.
+void link_policy_on_frame(const ds4_frame_t* frame);
+
+link_profile_t link_policy_get_profile(void);
+
+#endif  // LINK_POLICY_H_
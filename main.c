@@ -6,19 +6,64 @@
 #include <tusb.h>
 
 #include "comm.h"
+#include "connect_stats.h"
+#include "crc_engine.h"
 #include "debug.h"
+#include "irq_plan.h"
+#include "latency.h"
+#include "link_loss.h"
 #include "pico_bluetooth.h"
 #include "sdkconfig.h"
+#include "status_led.h"
+#include "synth_input.h"
 #include "tusb_config.h"
 #include "usb_descriptors.h"
+#include "usb_scheduler.h"
 
 // Sanity check
 #ifndef CONFIG_BLUEPAD32_PLATFORM_CUSTOM
 #error "Pico W must use BLUEPAD32_PLATFORM_CUSTOM"
 #endif
 
-#define BT_UPDATE_TIMEOUT_US 40000  // 40ms timeout for bluetooth packet updates
-#define BT_UPDATE_PER_SEC 250       // 250 times per second
+#define BT_UPDATE_TIMEOUT_US 40000       // timeout for bluetooth packet updates until the rate is known
+#define BT_UPDATE_TIMEOUT_PERIODS 10     // afterwards: this many missed bluetooth reports
+#define BT_UPDATE_TIMEOUT_MIN_US 20000   // but never less than 20ms
+#define BT_UPDATE_TIMEOUT_MAX_US 100000  // or more than 100ms
+#define BT_RATE_WINDOW_US 1000000        // the bluetooth report rate is measured over 1s
+#define USB_IDLE_WAKEUP_US 10000         // upper bound for WFE so timeouts are still checked
+#define USB_SETTLE_MS 1000               // after the first report is accepted, before forwarding
+
+// Bluetooth report rate actually achieved, and the update timeout derived
+// from it. Only used by core0.
+static uint32_t bt_rate_hz = 0;
+static uint32_t bt_update_timeout_us = BT_UPDATE_TIMEOUT_US;
+
+static void bt_rate_update(uint32_t now_us) {
+  static uint32_t window_start_us = 0;
+  static uint32_t window_reports = 0;
+
+  uint32_t elapsed_us = now_us - window_start_us;
+  if (elapsed_us < BT_RATE_WINDOW_US) {
+    return;
+  }
+  uint32_t reports = g_ds4_counters.bt_reports;
+  uint32_t delta = reports - window_reports;
+  window_start_us = now_us;
+  window_reports = reports;
+  if (delta == 0) {
+    // No input (not connected): keep the last timeout.
+    return;
+  }
+
+  bt_rate_hz = (uint32_t)((uint64_t)delta * 1000000 / elapsed_us);
+  uint32_t timeout_us = bt_rate_hz ? BT_UPDATE_TIMEOUT_PERIODS * (1000000 / bt_rate_hz) : BT_UPDATE_TIMEOUT_MAX_US;
+  if (timeout_us < BT_UPDATE_TIMEOUT_MIN_US) {
+    timeout_us = BT_UPDATE_TIMEOUT_MIN_US;
+  } else if (timeout_us > BT_UPDATE_TIMEOUT_MAX_US) {
+    timeout_us = BT_UPDATE_TIMEOUT_MAX_US;
+  }
+  bt_update_timeout_us = timeout_us;
+}
 
 void bluetooth_thread_run() {
   // initialize CYW43 driver architecture
@@ -26,7 +71,15 @@ void bluetooth_thread_run() {
     PICO_ERROR("failed to initialise cyw43_arch\n");
     return;
   }
+  irq_plan_core1();
+
+  if (g_ds4_bridge_mode == DS4_BRIDGE_MODE_SYNTHETIC) {
+    status_led_init(false);
+    synth_input_run(SYNTH_INPUT_RATE_HZ);
+    return;
+  }
 
+  crc_engine_init();
   bluetooth_init();
   bluetooth_run();
 }
@@ -37,31 +90,33 @@ void usb_thread_run() {
   tusb_rhport_init_t dev_init = {.role = TUSB_ROLE_DEVICE,
                                  .speed = TUSB_SPEED_AUTO};
   tusb_init(BOARD_TUD_RHPORT, &dev_init);
+  irq_plan_core0();
 
+  // USB interrupts end the WFE, so enumeration is serviced as it happens.
   while (!is_usb_mounted) {
     tud_task();
-    sleep_ms(10);
+    best_effort_wfe_or_timeout(make_timeout_time_us(USB_IDLE_WAKEUP_US));
   }
 
   // Wait for USB HID Device stack to be initialized
-  do {
+  while (true) {
     tud_task();
-    sleep_ms(10);
-  } while (!tud_hid_report(0x01, &zero_report, sizeof(ds4_report_t)));
+    if (tud_hid_report(0x01, &zero_report, sizeof(ds4_report_t))) {
+      break;
+    }
+    best_effort_wfe_or_timeout(make_timeout_time_us(USB_IDLE_WAKEUP_US));
+  }
 
-  // Wait for 1 second to ensure the device is ready
-  sleep_ms(1000);
+  // Give the host a second to settle, still answering its requests
+  absolute_time_t settled = make_timeout_time_ms(USB_SETTLE_MS);
+  while (!time_reached(settled)) {
+    tud_task();
+    best_effort_wfe_or_timeout(settled);
+  }
 
   // Communication variables
-  uint32_t last_updated = 0;
   uint32_t timestamp = 0;
   bool is_updated = false;
-  bool is_connected = false;
-  absolute_time_t last_reported = get_absolute_time();
-
-  // Blink LED every 250 reports
-  volatile uint32_t blink_on = 0;
-  volatile uint32_t counter = 0;
 
   // Stats based on time interval (디버그 모드에서만)
 #if IS_PICO_DEBUG
@@ -75,55 +130,74 @@ void usb_thread_run() {
   ds4_report_t* local_report_ptr = (ds4_report_t*)malloc(sizeof(ds4_report_t));
   if (local_report_ptr == NULL) {
     PICO_ERROR("failed to allocate memory for local report\n");
+    status_led_set_error(true);
     return;
   }
   memset(local_report_ptr, 0, sizeof(ds4_report_t));
 
+  usb_scheduler_init();
+
   while (true) {
     tud_task();
+    bt_rate_update(time_us_32());
 
-    ds4_frame_t data;
+    const ds4_frame_t* frame = NULL;
     ds4_report_t report;
+    uint32_t sched_due_us = 0;
+    bool sched_waiting = false;
 
     is_updated = false;
     if (tud_hid_ready() && !report_in_flight) {
-      SEQLOCK_TRY_READ(&data, g_ds4_shared);
-      int32_t time_diff = data.timestamp - last_updated;
-      if (time_diff > 0) {
-        last_updated = data.timestamp;
-        convert_uni_to_ds4(data.gamepad, data.battery, &report);
+      // Hold the frame until just before the host's next poll so it is as
+      // fresh as possible when read.
+      sched_waiting = !usb_scheduler_is_due(time_us_32(), &sched_due_us);
+      if (!sched_waiting && TRIPLE_BUFFER_READ(g_ds4_shared)) {
+        frame = TRIPLE_BUFFER_READ_SLOT(g_ds4_shared);
+
+        uint32_t now_us = time_us_32();
+        uint32_t wait_us = now_us - frame->timestamp;
+        latency_on_pickup(frame->rx_timestamp, frame->timestamp, now_us);
+        g_ds4_pickup_stats.frames++;
+        g_ds4_pickup_stats.wait_us_last = wait_us;
+        g_ds4_pickup_stats.wait_us_total += wait_us;
+        if (wait_us > g_ds4_pickup_stats.wait_us_max) {
+          g_ds4_pickup_stats.wait_us_max = wait_us;
+        }
+        if (frame->mode == DS4_BRIDGE_MODE_PASSTHROUGH) {
+          convert_raw_to_ds4(frame->raw, &report);
+        } else {
+          convert_uni_to_ds4(frame->gamepad, frame->battery, &report);
+        }
 
         is_updated = true;
-        is_connected = true;
       }
 
-      // report when dualshock4 is updated or send default report if update is
-      // not received for 5ms
+      // report when dualshock4 is updated, or move towards the neutral report
+      // if no update arrived within the timeout (link_loss.h)
       if (is_updated && tud_hid_report(0x01, &report, sizeof(ds4_report_t))) {
         report_in_flight = true;
-        last_reported = get_absolute_time();
-        // blink the LED every 250 reports
-        if (counter++ % (BT_UPDATE_PER_SEC / 2) == 0) {
-          cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, blink_on ^= 1);
-          sleep_us(100);
-        }
+        latency_on_submit(time_us_32());
+        usb_scheduler_on_submit(frame->timestamp, true);
+        g_ds4_counters.usb_forwarded++;
+        connect_stats_on_forwarded();
+        status_led_on_activity();
+        g_ds4_counters.usb_reports++;
+        link_loss_on_frame(&report, time_us_32());
 #if IS_PICO_DEBUG
         ds4_update_count++;
 #endif
-      } else if (is_connected) {
-        absolute_time_t now = get_absolute_time();
-        int64_t elapsed_us = absolute_time_diff_us(last_reported, now);
-        if (elapsed_us > BT_UPDATE_TIMEOUT_US) {
-          if (tud_hid_report(0x01, &zero_report, sizeof(ds4_report_t))) {
-            report_in_flight = true;
-            last_reported = get_absolute_time();
-            is_connected = false;
-            sleep_ms(100);
+      } else if (!is_updated && link_loss_poll(time_us_32(), bt_update_timeout_us, &report) &&
+                 tud_hid_report(0x01, &report, sizeof(ds4_report_t))) {
+        report_in_flight = true;
+        usb_scheduler_on_submit(0, false);
+        g_ds4_counters.usb_reports++;
+        link_loss_on_sent(time_us_32());
+        if (link_loss_get_state() == LINK_LOSS_NEUTRAL) {
+          g_ds4_counters.usb_timeouts++;
 #if IS_PICO_DEBUG
-            ds4_missed_count++;
-            PICO_DEBUG("[USB] USB report missed for %lld us.\n", elapsed_us);
+          ds4_missed_count++;
+          PICO_DEBUG("[USB] No update for %u us, neutral report sent.\n", bt_update_timeout_us);
 #endif
-          }
         }
       }
 
@@ -134,8 +208,20 @@ void usb_thread_run() {
         double elapsed_sec =
             absolute_time_diff_us(stat_start_time, now) / 1000000.0;
         last_stat_time = now;
-        PICO_DEBUG("[USB] USB Elapsed: %f, Updates: %u, Misses: %u\n",
-                   elapsed_sec, ds4_update_count, ds4_missed_count);
+        PICO_DEBUG("[USB] USB Elapsed: %f, Updates: %u, Misses: %u, Overwritten: %u\n",
+                   elapsed_sec, ds4_update_count, ds4_missed_count,
+                   atomic_load_explicit(&g_ds4_shared.overwritten, memory_order_relaxed));
+        PICO_DEBUG("[USB] BT rate: %u Hz, update timeout: %u us\n", bt_rate_hz,
+                   bt_update_timeout_us);
+        if (g_ds4_pickup_stats.frames > 0) {
+          PICO_DEBUG("[USB] Pickup wait: avg %llu us, max %u us\n",
+                     g_ds4_pickup_stats.wait_us_total / g_ds4_pickup_stats.frames,
+                     g_ds4_pickup_stats.wait_us_max);
+        }
+        const usb_scheduler_stats_t* sched = usb_scheduler_get_stats();
+        PICO_DEBUG("[USB] Poll phase: %s %u us (err %d us), frame age max %u us\n",
+                   sched->locked ? "locked" : "unlocked", sched->phase_us,
+                   sched->phase_error_us, sched->age_max_us);
         ds4_update_count = 0;
         ds4_missed_count = 0;
       }
@@ -145,7 +231,21 @@ void usb_thread_run() {
     if (tud_suspended()) {
       tud_remote_wakeup();
     }
-    sleep_ms(1);
+
+    // Sleep until core1 publishes a new frame (SEV), a USB interrupt fires or
+    // the idle deadline expires. Skip the sleep if TinyUSB already has work.
+    if (!tud_task_event_ready()) {
+      uint32_t sleep_us = USB_IDLE_WAKEUP_US;
+      if (sched_waiting) {
+        int32_t until_due_us = (int32_t)(sched_due_us - time_us_32());
+        if (until_due_us < (int32_t)sleep_us) {
+          sleep_us = until_due_us > 0 ? (uint32_t)until_due_us : 0;
+        }
+      }
+      if (sleep_us > 0) {
+        best_effort_wfe_or_timeout(make_timeout_time_us(sleep_us));
+      }
+    }
   }
 }
 
@@ -160,8 +260,6 @@ int main() {
 
   PICO_INFO("RPI PICO 2W started.\n");
 
-  // initialize dualshock4 shared data
-  g_ds4_shared.data.timestamp = to_ms_since_boot(get_absolute_time());
   sleep_ms(250);
 
   // Initialize the CYW43 driver
@@ -1,25 +1,51 @@
 #include "pico_bluetooth.h"
 
+#include <stdarg.h>
 #include <stddef.h>
 #include <string.h>
 
 #include <bt/uni_bt.h>
 #include <btstack.h>
 #include <controller/uni_gamepad.h>
+#include <parser/uni_hid_parser.h>
 #include <pico/cyw43_arch.h>
 #include <pico/time.h>
 #include <uni.h>
 #include <uni_hid_device.h>
 
+#include "bt_trace.h"
 #include "comm.h"
+#include "connect_stats.h"
+#include "crc_engine.h"
 #include "debug.h"
 #include "dualshock4.h"
+#include "frame_aggregator.h"
+#include "host_output.h"
+#include "latency.h"
+#include "link_policy.h"
+#include "reconnect.h"
+#include "scan_policy.h"
 #include "sdkconfig.h"
+#include "status_led.h"
 
 #ifndef CONFIG_BLUEPAD32_PLATFORM_CUSTOM
 #error "Pico W must use BLUEPAD32_PLATFORM_CUSTOM"
 #endif
 
+// Some DS4 clones send 0x11 reports without a valid CRC. If the first
+// INPUT_CRC_PROBE_REPORTS of a connection all fail, checking is turned off
+// until the next one instead of dropping all input.
+#define INPUT_CRC_PROBE_REPORTS 16
+
+// D-pad and button bytes of ds4_report_t, from DS4_BT_REPORT_11_PAYLOAD on.
+#define DS4_RAW_BUTTONS 4
+
+static struct {
+  uint8_t failures;  // before the first valid CRC
+  bool valid_seen;
+  bool disabled;
+} input_crc;
+
 // Declarations
 static void trigger_event_on_gamepad(uni_hid_device_t* d);
 
@@ -33,12 +59,9 @@ static void pico_bluetooth_on_init_complete(void) {
   // Safe to call "unsafe" functions since they are called
   PICO_INFO("Bluetooth initialization complete.\n");
 
-  // Delete stored BT keys for fresh pairing (helpful for initial connection)
-  uni_bt_del_keys_unsafe();
-
-  // Start scanning and autoconnect to supported controllers.
-  uni_bt_start_scanning_and_autoconnect_safe();
-  PICO_INFO("Started Bluetooth scanning for new devices.\n");
+  // Page the last controller, or scan and autoconnect to supported controllers
+  // if there is none. Pairings are kept so a known controller reconnects fast.
+  reconnect_start();
 
   uni_property_dump_all();
 }
@@ -72,21 +95,44 @@ static void pico_bluetooth_on_device_connected(uni_hid_device_t* d) {
   PICO_INFO("Device connected: %s (%02X:%02X:%02X:%02X:%02X:%02X)\n", d->name, d->conn.btaddr[0], d->conn.btaddr[1],
             d->conn.btaddr[2], d->conn.btaddr[3], d->conn.btaddr[4], d->conn.btaddr[5]);
 
-  // Disable scanning when a device is connected to save power
-  uni_bt_stop_scanning_safe();
+  connect_path_t path = uni_hid_device_is_incoming(d) ? CONNECT_PATH_INCOMING
+                        : reconnect_is_directed(d)      ? CONNECT_PATH_DIRECTED
+                                                        : CONNECT_PATH_INQUIRY;
+  connect_stats_on_connected(path);
+  reconnect_on_connected(d);
+
+  // Stop page scan and inquiry while a device is connected to save power
+  scan_policy_on_connected();
   PICO_DEBUG("[BT] Stopped scanning (device connected)\n");
+
+  if (d->conn.protocol == UNI_BT_CONN_PROTOCOL_BR_EDR) {
+    link_policy_on_connected(d->conn.handle);
+  }
 }
 
 static void pico_bluetooth_on_device_disconnected(uni_hid_device_t* d) {
   PICO_INFO("Device disconnected: %s (%02X:%02X:%02X:%02X:%02X:%02X)\n", d->name, d->conn.btaddr[0], d->conn.btaddr[1],
             d->conn.btaddr[2], d->conn.btaddr[3], d->conn.btaddr[4], d->conn.btaddr[5]);
 
-  // Re-enable scanning when a device is disconnected
-  uni_bt_start_scanning_and_autoconnect_safe();
-  PICO_DEBUG("[BT] Restarted scanning (device disconnected)\n");
+  memset(&input_crc, 0, sizeof(input_crc));
+  link_policy_on_disconnected(d->conn.handle);
+  connect_stats_on_disconnected();
+  status_led_set_state(STATUS_LED_IDLE);
+  host_output_on_disconnected(d);
+
+  // Page scan fast for a while and page the controller again, falling back to
+  // scanning
+  scan_policy_on_disconnected();
+  reconnect_on_disconnected();
+  PICO_DEBUG("[BT] Reconnecting (device disconnected)\n");
 }
 
 static uni_error_t pico_bluetooth_on_device_ready(uni_hid_device_t* d) {
+  connect_stats_on_ready(d->sdp_cached);
+  reconnect_on_ready(d);
+  status_led_set_state(STATUS_LED_CONNECTED);
+  host_output_on_ready(d);
+
   // You can reject the connection by returning an error.
   return UNI_ERROR_SUCCESS;
 }
@@ -98,7 +144,7 @@ static const uni_property_t* pico_bluetooth_get_property(uni_property_idx_t idx)
 
 static void pico_bluetooth_on_controller_data(uni_hid_device_t* d, uni_controller_t* ctl) {
   absolute_time_t now = get_absolute_time();
-  uint64_t now_since_boot = to_us_since_boot(now);
+  latency_on_parsed((uint32_t)to_us_since_boot(now));
 
 #if IS_PICO_DEBUG
   static int count = 0;
@@ -115,15 +161,19 @@ static void pico_bluetooth_on_controller_data(uni_hid_device_t* d, uni_controlle
 #endif
 
   switch (ctl->klass) {
-    case UNI_CONTROLLER_CLASS_GAMEPAD:
+    case UNI_CONTROLLER_CLASS_GAMEPAD: {
       // Print device Id and dump gamepad.
       // uni_controller_dump(ctl);
-      seqlock_write_begin(&g_ds4_shared.seq);
-      g_ds4_shared.data.gamepad = ctl->gamepad;
-      g_ds4_shared.data.battery = ctl->battery;
-      g_ds4_shared.data.timestamp = now_since_boot;
-      seqlock_write_end(&g_ds4_shared.seq);
+      ds4_frame_t* frame = TRIPLE_BUFFER_WRITE_SLOT(g_ds4_shared);
+      frame->mode = DS4_BRIDGE_MODE_NORMALIZED;
+      frame->gamepad = ctl->gamepad;
+      frame->battery = ctl->battery;
+      frame->timestamp = time_us_32();
+      frame->rx_timestamp = latency_on_publish(frame->timestamp);
+      link_policy_on_frame(frame);
+      frame_aggregator_publish(frame);
       break;
+    }
     case UNI_CONTROLLER_CLASS_BALANCE_BOARD:
       // DO NOTHING
       break;
@@ -139,6 +189,78 @@ static void pico_bluetooth_on_controller_data(uni_hid_device_t* d, uni_controlle
   }
 }
 
+// DS4 report 0x11 ends with a CRC32 over the 0xA1 HID header and the report.
+static bool input_crc_valid(const uint8_t* report, uint16_t len) {
+  static const uint8_t header = 0xa1;
+  uint32_t crc = uni_crc32_le(0xffffffff, &header, 1);
+  crc = ~uni_crc32_le(crc, report, len - 4);
+  uint32_t expected = report[len - 4] | report[len - 3] << 8 | report[len - 2] << 16 | (uint32_t)report[len - 1] << 24;
+  if (crc == expected) {
+    input_crc.valid_seen = true;
+    return true;
+  }
+  g_ds4_counters.bt_crc_errors++;
+  if (!input_crc.valid_seen && ++input_crc.failures >= INPUT_CRC_PROBE_REPORTS) {
+    input_crc.disabled = true;
+    PICO_INFO("[BT] Input reports carry no valid CRC, not checking them\n");
+  }
+  return false;
+}
+
+static bool pico_bluetooth_on_raw_input_report(uni_hid_device_t* d, const uint8_t* report, uint16_t len) {
+  // Every input report passes through here before it is parsed.
+  uint32_t now_us = time_us_32();
+  latency_on_l2cap_rx(now_us);
+  bt_trace_record(report, len, now_us);
+
+  uint8_t depth = uni_output_queue_get_depth(&d->output_queue);
+  const uni_output_queue_stats_t* out = uni_output_queue_get_stats();
+  g_ds4_counters.bt_reports++;
+  g_ds4_counters.bt_out_sent = out->sent;
+  g_ds4_counters.bt_out_merged = out->merged;
+  g_ds4_counters.bt_out_dropped = out->dropped;
+  g_ds4_counters.bt_out_deferred = out->deferred;
+  g_ds4_counters.bt_queue_depth = depth;
+  if (depth > g_ds4_counters.bt_queue_max) {
+    g_ds4_counters.bt_queue_max = depth;
+  }
+
+  // A corrupted report is dropped here, before either path sees it.
+  if (CRC_ENGINE_VERIFY_INPUT && !input_crc.disabled && d->controller_type == CONTROLLER_TYPE_PS4Controller &&
+      len == DS4_BT_REPORT_11_LEN && report[0] == DS4_BT_REPORT_11_ID && !input_crc_valid(report, len)) {
+    return true;
+  }
+
+  if (g_ds4_bridge_mode != DS4_BRIDGE_MODE_PASSTHROUGH) {
+    return false;
+  }
+
+  // Only full DS4 reports can be forwarded as-is. Report 0x01 and other
+  // controllers go through the Bluepad32 parser.
+  if (d->controller_type != CONTROLLER_TYPE_PS4Controller || len != DS4_BT_REPORT_11_LEN ||
+      report[0] != DS4_BT_REPORT_11_ID) {
+    return false;
+  }
+
+  if (uni_bt_conn_get_state(&d->conn) != UNI_BT_CONN_STATE_DEVICE_READY) {
+    return false;
+  }
+
+  ds4_frame_t* frame = TRIPLE_BUFFER_WRITE_SLOT(g_ds4_shared);
+  frame->mode = DS4_BRIDGE_MODE_PASSTHROUGH;
+  memcpy(frame->raw, &report[DS4_BT_REPORT_11_PAYLOAD], sizeof(frame->raw));
+  frame->timestamp = time_us_32();
+  frame->rx_timestamp = latency_on_publish(frame->timestamp);
+  link_policy_on_frame(frame);
+  frame_aggregator_publish(frame);
+
+  // The Bluepad32 parser is skipped, but not its PS / Options button handling.
+  uni_hid_parser_ds_buttons(&report[DS4_BT_REPORT_11_PAYLOAD + DS4_RAW_BUTTONS], false, &d->controller.gamepad);
+  uni_hid_device_process_misc_buttons(d);
+
+  return true;
+}
+
 static void pico_bluetooth_on_oob_event(uni_platform_oob_event_t event, void* data) {
   switch (event) {
     case UNI_PLATFORM_OOB_GAMEPAD_SYSTEM_BUTTON:
@@ -170,6 +292,33 @@ static void trigger_event_on_gamepad(uni_hid_device_t* d) {
   }
 }
 
+// BTstack passes every HCI packet to the dump hook before processing it. It is
+// the earliest point an ACL packet is visible to us, so it marks the HCI
+// receive stage. Log messages are discarded, as before: their levels are
+// turned off when the hook is installed, so log_info() / log_error() return
+// before reaching it.
+static void latency_hci_dump_reset(void) {}
+
+static void latency_hci_dump_log_packet(uint8_t packet_type, uint8_t in, uint8_t* packet, uint16_t len) {
+  ARG_UNUSED(packet);
+  ARG_UNUSED(len);
+  if (in && packet_type == HCI_ACL_DATA_PACKET) {
+    latency_on_hci_acl_rx(time_us_32());
+  }
+}
+
+static void latency_hci_dump_log_message(int log_level, const char* format, va_list argptr) {
+  ARG_UNUSED(log_level);
+  ARG_UNUSED(format);
+  ARG_UNUSED(argptr);
+}
+
+static const hci_dump_t latency_hci_dump = {
+    .reset = latency_hci_dump_reset,
+    .log_packet = latency_hci_dump_log_packet,
+    .log_message = latency_hci_dump_log_message,
+};
+
 struct uni_platform* get_my_platform(void) {
   static struct uni_platform plat = {
       .name = "Pico2 W",
@@ -181,6 +330,7 @@ struct uni_platform* get_my_platform(void) {
       .on_device_ready = pico_bluetooth_on_device_ready,
       .on_oob_event = pico_bluetooth_on_oob_event,
       .on_controller_data = pico_bluetooth_on_controller_data,
+      .on_raw_input_report = pico_bluetooth_on_raw_input_report,
       .get_property = pico_bluetooth_get_property,
   };
 
@@ -194,6 +344,11 @@ void bluetooth_init(void) {
   // cyw43_arch_disable_sta_mode();
   cyw43_arch_disable_ap_mode();
 
+  hci_dump_init(&latency_hci_dump);
+  hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_DEBUG, 0);
+  hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_INFO, 0);
+  hci_dump_enable_log_level(HCI_DUMP_LOG_LEVEL_ERROR, 0);
+
   // Must be called before uni_init()
   uni_platform_set_custom(get_my_platform());
   PICO_DEBUG("[INIT] Custom platform registered\n");
@@ -201,6 +356,12 @@ void bluetooth_init(void) {
   // Initialize BP32
   uni_init(0, NULL);
   PICO_INFO("Bluepad32 initialized\n");
+
+  link_policy_init();
+  scan_policy_init();
+  connect_stats_init();
+  status_led_init(true);
+  host_output_init();
 }
 
 void bluetooth_run(void) {
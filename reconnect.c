@@ -0,0 +1,162 @@
+#include "reconnect.h"
+
+#include <string.h>
+
+#include <bt/uni_bt.h>
+#include <bt/uni_bt_bredr.h>
+#include <bt/uni_bt_defines.h>
+#include <btstack.h>
+#include <btstack_tlv.h>
+
+#include "debug.h"
+
+// 'D' 'S' '4' + index, next to Bluepad32's own 'B' 'P' '3' property tags.
+#define RECONNECT_TLV_TAG (('D' << 24) | ('S' << 16) | ('4' << 8) | 0x01)
+#define RECONNECT_NAME_LEN 32
+
+typedef struct {
+  bd_addr_t addr;
+  uint8_t page_scan_repetition_mode;
+  uint16_t clock_offset;  // incl. UNI_BT_CLOCK_OFFSET_VALID
+  uint32_t cod;
+  char name[RECONNECT_NAME_LEN];
+} reconnect_record_t;
+
+static reconnect_record_t last;
+static bool last_valid = false;
+static bool last_loaded = false;
+
+static bool directed = false;  // a directed connection to `last` is in progress
+static btstack_timer_source_t fallback_timer;
+static btstack_timer_source_t start_timer;
+
+static bool tlv_get(const btstack_tlv_t** impl, void** context) {
+  btstack_tlv_get_instance(impl, context);
+  return *impl != NULL;
+}
+
+static void reconnect_load(void) {
+  const btstack_tlv_t* impl;
+  void* context;
+
+  last_loaded = true;
+  if (!tlv_get(&impl, &context)) {
+    return;
+  }
+  last_valid = impl->get_tag(context, RECONNECT_TLV_TAG, (uint8_t*)&last, sizeof(last)) == sizeof(last);
+  last.name[RECONNECT_NAME_LEN - 1] = 0;
+}
+
+static void reconnect_store(void) {
+  const btstack_tlv_t* impl;
+  void* context;
+
+  if (!tlv_get(&impl, &context)) {
+    return;
+  }
+  if (impl->store_tag(context, RECONNECT_TLV_TAG, (const uint8_t*)&last, sizeof(last))) {
+    PICO_ERROR("Failed to store the last controller\n");
+  }
+}
+
+static void fallback_to_scanning(btstack_timer_source_t* ts) {
+  (void)ts;
+  directed = false;
+  PICO_INFO("Reconnect: %s did not connect, scanning for controllers\n", bd_addr_to_str(last.addr));
+  uni_bt_start_scanning_and_autoconnect_unsafe();
+}
+
+void reconnect_start(void) {
+  if (!last_loaded) {
+    reconnect_load();
+#if RECONNECT_FORGET_ON_BOOT
+    uni_bt_del_keys_unsafe();
+    last_valid = false;
+#endif
+  }
+
+  link_key_t key;
+  link_key_type_t key_type;
+  if (!last_valid || !gap_get_link_key_for_bd_addr(last.addr, key, &key_type)) {
+    // Nothing to reconnect to, or the controller was unpaired.
+    uni_bt_start_scanning_and_autoconnect_unsafe();
+    return;
+  }
+
+  // Page scan (connectable) stays on; only the inquiry is held back.
+  uni_bt_stop_scanning_unsafe();
+  PICO_INFO("Reconnect: paging %s (%s)\n", bd_addr_to_str(last.addr), last.name);
+  directed = uni_bt_bredr_connect_known_device(last.addr, last.cod, last.name, last.page_scan_repetition_mode,
+                                               last.clock_offset);
+  if (!directed) {
+    // The device slot is still in use or none is free: don't wait for a page
+    // that was never sent.
+    PICO_ERROR("Reconnect: could not page %s, scanning for controllers\n", bd_addr_to_str(last.addr));
+    uni_bt_start_scanning_and_autoconnect_unsafe();
+    return;
+  }
+
+  btstack_run_loop_remove_timer(&fallback_timer);
+  btstack_run_loop_set_timer_handler(&fallback_timer, &fallback_to_scanning);
+  btstack_run_loop_set_timer(&fallback_timer, RECONNECT_TIMEOUT_MS);
+  btstack_run_loop_add_timer(&fallback_timer);
+}
+
+static void start_after_disconnect(btstack_timer_source_t* ts) {
+  (void)ts;
+  reconnect_start();
+}
+
+void reconnect_on_disconnected(void) {
+  btstack_run_loop_remove_timer(&start_timer);
+  btstack_run_loop_set_timer_handler(&start_timer, &start_after_disconnect);
+  btstack_run_loop_set_timer(&start_timer, 0);
+  btstack_run_loop_add_timer(&start_timer);
+}
+
+void reconnect_on_connected(uni_hid_device_t* d) {
+  (void)d;
+  btstack_run_loop_remove_timer(&start_timer);
+  btstack_run_loop_remove_timer(&fallback_timer);
+}
+
+void reconnect_on_ready(uni_hid_device_t* d) {
+  if (d->conn.protocol != UNI_BT_CONN_PROTOCOL_BR_EDR) {
+    return;
+  }
+
+  reconnect_record_t record;
+  memset(&record, 0, sizeof(record));
+  bd_addr_copy(record.addr, d->conn.btaddr);
+  record.cod = d->cod;
+  // Keep what the last inquiry learned if the controller connected by itself.
+  bool same = last_valid && bd_addr_cmp(last.addr, d->conn.btaddr) == 0;
+  if (d->conn.clock_offset & UNI_BT_CLOCK_OFFSET_VALID) {
+    record.page_scan_repetition_mode = d->conn.page_scan_repetition_mode;
+    record.clock_offset = d->conn.clock_offset;
+  } else if (same) {
+    record.page_scan_repetition_mode = last.page_scan_repetition_mode;
+    record.clock_offset = last.clock_offset;
+  } else {
+    record.page_scan_repetition_mode = 0x02;  // R2, same default as the name request
+  }
+  // A cached controller can be ready before its name arrives.
+  if (uni_hid_device_has_name(d)) {
+    strncpy(record.name, d->name, RECONNECT_NAME_LEN - 1);
+  } else if (same) {
+    memcpy(record.name, last.name, sizeof(record.name));
+  }
+
+  // Flash is only written when something changed.
+  if (last_valid && memcmp(&record, &last, sizeof(record)) == 0) {
+    return;
+  }
+  last = record;
+  last_valid = true;
+  reconnect_store();
+  PICO_INFO("Reconnect: remembering %s\n", bd_addr_to_str(last.addr));
+}
+
+bool reconnect_is_directed(uni_hid_device_t* d) {
+  return directed && bd_addr_cmp(last.addr, d->conn.btaddr) == 0 && !uni_hid_device_is_incoming(d);
+}
@@ -0,0 +1,159 @@
+#include "scan_policy.h"
+
+#include <stdbool.h>
+
+#include <bt/uni_bt.h>
+#include <bt/uni_bt_bredr.h>
+#include <btstack.h>
+
+#include "connect_stats.h"
+#include "debug.h"
+
+#define ACCOUNT_MS 1000
+
+typedef struct {
+  uint16_t page_interval;
+  uint16_t page_window;
+  uint8_t inquiry_length;
+  uint8_t inquiry_min;
+  uint8_t inquiry_max;
+} scan_params_t;
+
+static const scan_params_t fast_params = {
+    SCAN_POLICY_FAST_PAGE_INTERVAL,  SCAN_POLICY_FAST_PAGE_WINDOW, SCAN_POLICY_FAST_INQUIRY_LENGTH,
+    SCAN_POLICY_FAST_INQUIRY_MIN,    SCAN_POLICY_FAST_INQUIRY_MAX,
+};
+
+static const scan_params_t relaxed_params = {
+    SCAN_POLICY_RELAXED_PAGE_INTERVAL, SCAN_POLICY_RELAXED_PAGE_WINDOW, SCAN_POLICY_RELAXED_INQUIRY_LENGTH,
+    SCAN_POLICY_RELAXED_INQUIRY_MIN,   SCAN_POLICY_RELAXED_INQUIRY_MAX,
+};
+
+static struct {
+  scan_phase_t phase;
+  const scan_params_t* params;  // NULL while streaming
+  bool restart_inquiry;         // waiting for the periodic inquiry to stop, to start it with new timing
+  uint32_t accounted_ms;
+  uint64_t page_scan_us;
+  uint64_t inquiry_us;
+} scan;
+
+static btstack_packet_callback_registration_t hci_event_callback_registration;
+static btstack_timer_source_t phase_timer;
+static btstack_timer_source_t account_timer;
+
+// Adds the radio time since the last call, at the duty cycle of the phase
+// that was active.
+static void scan_account(void) {
+  uint32_t now = btstack_run_loop_get_time_ms();
+  uint64_t elapsed_us = (uint64_t)(now - scan.accounted_ms) * 1000u;
+  scan.accounted_ms = now;
+
+  const scan_params_t* p = scan.params;
+  if (p != NULL) {
+    scan.page_scan_us += elapsed_us * 2u * p->page_window / p->page_interval;
+    if (uni_bt_is_scanning()) {
+      scan.inquiry_us += elapsed_us * 2u * p->inquiry_length / (p->inquiry_min + p->inquiry_max);
+    }
+  }
+}
+
+static void scan_publish(void) {
+  connect_stats_on_scan(scan.phase, (uint32_t)(scan.page_scan_us / 1000u), (uint32_t)(scan.inquiry_us / 1000u));
+}
+
+static void scan_account_tick(btstack_timer_source_t* ts) {
+  scan_account();
+  scan_publish();
+  if (scan.phase != SCAN_PHASE_STREAMING) {
+    btstack_run_loop_set_timer(ts, ACCOUNT_MS);
+    btstack_run_loop_add_timer(ts);
+  }
+}
+
+static void scan_enter(scan_phase_t phase) {
+  scan_account();
+  scan.phase = phase;
+  scan.restart_inquiry = false;
+  btstack_run_loop_remove_timer(&phase_timer);
+  btstack_run_loop_remove_timer(&account_timer);
+
+  if (phase == SCAN_PHASE_STREAMING) {
+    scan.params = NULL;
+    gap_connectable_control(0);
+    uni_bt_stop_scanning_unsafe();
+    PICO_INFO("Scan: off (streaming)\n");
+    scan_publish();
+    return;
+  }
+
+  const scan_params_t* p = phase == SCAN_PHASE_FAST ? &fast_params : &relaxed_params;
+  scan.params = p;
+  gap_set_page_scan_activity(p->page_interval, p->page_window);
+  gap_connectable_control(1);
+  uni_bt_bredr_set_inquiry_timing(p->inquiry_length, p->inquiry_min, p->inquiry_max);
+  // A running periodic inquiry keeps its timing until it is restarted.
+  if (uni_bt_is_scanning()) {
+    uni_bt_stop_scanning_unsafe();
+    scan.restart_inquiry = true;
+  }
+  PICO_INFO("Scan: %s page scan %u/%u slots, inquiry %u every %u..%u (x1.28s)\n",
+            phase == SCAN_PHASE_FAST ? "fast" : "relaxed", p->page_window, p->page_interval, p->inquiry_length,
+            p->inquiry_min, p->inquiry_max);
+
+  if (phase == SCAN_PHASE_FAST) {
+    btstack_run_loop_set_timer(&phase_timer, SCAN_POLICY_FAST_MS);
+    btstack_run_loop_add_timer(&phase_timer);
+  }
+  btstack_run_loop_set_timer(&account_timer, ACCOUNT_MS);
+  btstack_run_loop_add_timer(&account_timer);
+  scan_publish();
+}
+
+static void scan_fast_expired(btstack_timer_source_t* ts) {
+  (void)ts;
+  scan_enter(SCAN_PHASE_RELAXED);
+}
+
+static void scan_packet_handler(uint8_t packet_type, uint16_t channel, uint8_t* packet, uint16_t size) {
+  (void)channel;
+  (void)size;
+
+  if (packet_type != HCI_EVENT_PACKET) {
+    return;
+  }
+  switch (hci_event_packet_get_type(packet)) {
+    case HCI_EVENT_COMMAND_COMPLETE:
+      if (scan.restart_inquiry &&
+          hci_event_command_complete_get_command_opcode(packet) == hci_exit_periodic_inquiry_mode.opcode) {
+        scan.restart_inquiry = false;
+        uni_bt_start_scanning_and_autoconnect_unsafe();
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+void scan_policy_init(void) {
+  hci_event_callback_registration.callback = &scan_packet_handler;
+  hci_add_event_handler(&hci_event_callback_registration);
+  btstack_run_loop_set_timer_handler(&phase_timer, &scan_fast_expired);
+  btstack_run_loop_set_timer_handler(&account_timer, &scan_account_tick);
+  scan.accounted_ms = btstack_run_loop_get_time_ms();
+  scan_enter(SCAN_PHASE_FAST);
+}
+
+void scan_policy_on_connected(void) {
+  if (scan.phase != SCAN_PHASE_STREAMING) {
+    scan_enter(SCAN_PHASE_STREAMING);
+  }
+}
+
+void scan_policy_on_disconnected(void) {
+  scan_enter(SCAN_PHASE_FAST);
+}
+
+scan_phase_t scan_policy_get_phase(void) {
+  return scan.phase;
+}
@@ -0,0 +1,87 @@
+#include "status_led.h"
+
+#include <stdatomic.h>
+
+#include <btstack.h>
+#include <pico/cyw43_arch.h>
+#include <pico/time.h>
+
+#if STATUS_LED_GPIO >= 0
+#include <hardware/gpio.h>
+#endif
+
+#define PATTERN_TICKS 16
+
+// Mailbox: latest value wins, the renderer only ever reads.
+static _Atomic uint8_t requested_state;
+static _Atomic bool requested_error;
+static _Atomic uint32_t activity_us;
+static _Atomic bool activity_seen;
+
+// Renderer state, core1 only.
+static uint32_t tick;
+static int level = -1;  // unknown: first tick always writes
+static btstack_timer_source_t render_timer;
+
+static void led_put(bool on) {
+#if STATUS_LED_GPIO >= 0
+  gpio_put(STATUS_LED_GPIO, on);
+#else
+  cyw43_arch_gpio_put(CYW43_WL_GPIO_LED_PIN, on);
+#endif
+}
+
+static uint16_t current_pattern(void) {
+  if (atomic_load_explicit(&requested_error, memory_order_relaxed)) {
+    return STATUS_LED_PATTERN_ERROR;
+  }
+  if (atomic_load_explicit(&activity_seen, memory_order_relaxed) &&
+      time_us_32() - atomic_load_explicit(&activity_us, memory_order_relaxed) < STATUS_LED_ACTIVITY_MS * 1000u) {
+    return STATUS_LED_PATTERN_STREAMING;
+  }
+  if (atomic_load_explicit(&requested_state, memory_order_relaxed) == STATUS_LED_CONNECTED) {
+    return STATUS_LED_PATTERN_CONNECTED;
+  }
+  return STATUS_LED_PATTERN_IDLE;
+}
+
+void status_led_tick(void) {
+  int on = (current_pattern() >> (tick % PATTERN_TICKS)) & 1;
+  tick++;
+  if (on != level) {
+    level = on;
+    led_put(on);
+  }
+}
+
+static void render_timer_handler(btstack_timer_source_t* ts) {
+  status_led_tick();
+  btstack_run_loop_set_timer(ts, STATUS_LED_TICK_MS);
+  btstack_run_loop_add_timer(ts);
+}
+
+void status_led_init(bool btstack_timer) {
+#if STATUS_LED_GPIO >= 0
+  gpio_init(STATUS_LED_GPIO);
+  gpio_set_dir(STATUS_LED_GPIO, GPIO_OUT);
+#endif
+  status_led_tick();
+  if (btstack_timer) {
+    btstack_run_loop_set_timer_handler(&render_timer, &render_timer_handler);
+    btstack_run_loop_set_timer(&render_timer, STATUS_LED_TICK_MS);
+    btstack_run_loop_add_timer(&render_timer);
+  }
+}
+
+void status_led_set_state(status_led_state_t state) {
+  atomic_store_explicit(&requested_state, (uint8_t)state, memory_order_relaxed);
+}
+
+void status_led_set_error(bool error) {
+  atomic_store_explicit(&requested_error, error, memory_order_relaxed);
+}
+
+void status_led_on_activity(void) {
+  atomic_store_explicit(&activity_us, time_us_32(), memory_order_relaxed);
+  atomic_store_explicit(&activity_seen, true, memory_order_relaxed);
+}
@@ -0,0 +1,63 @@
+#ifndef STATUS_LED_H_
+#define STATUS_LED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Status LED
+ * ----------
+ * The Pico 2 W LED hangs off the cyw43 chip, so every change is a transfer on
+ * the same bus Bluetooth uses. Callers on either core only post requests:
+ *
+ *   - the connection state, from core1 (pico_bluetooth.c)
+ *   - report activity, from core0 each time a frame is forwarded (one store)
+ *   - an error flag, from either core
+ *
+ * Core1 renders the pattern every STATUS_LED_TICK_MS from a BTstack timer, so
+ * the LED is written between HCI transactions and only when its level changes.
+ * In synthetic mode, where BTstack does not run, the generator loop ticks it.
+ *
+ * Patterns are 16 ticks of STATUS_LED_TICK_MS (2s), bit 0 first, in priority
+ * order:
+ *
+ *   error       fast blink
+ *   streaming   blink every 500ms while reports reach the host
+ *   connected   on
+ *   idle        off
+ *
+ * Set STATUS_LED_GPIO to a pin number to drive an external LED on a plain GPIO
+ * instead; that keeps the cyw43 bus to Bluetooth alone.
+ */
+
+#ifndef STATUS_LED_GPIO
+#define STATUS_LED_GPIO -1            // -1: cyw43 LED (CYW43_WL_GPIO_LED_PIN)
+#endif
+
+#define STATUS_LED_TICK_MS 125
+#define STATUS_LED_ACTIVITY_MS 250    // streaming while a frame was forwarded this recently
+
+#define STATUS_LED_PATTERN_ERROR 0x5555
+#define STATUS_LED_PATTERN_STREAMING 0x0F0F
+#define STATUS_LED_PATTERN_CONNECTED 0xFFFF
+#define STATUS_LED_PATTERN_IDLE 0x0000
+
+typedef enum {
+  STATUS_LED_IDLE = 0,
+  STATUS_LED_CONNECTED,
+} status_led_state_t;
+
+// Core1, after cyw43_arch_init(). Starts the render timer if BTstack runs.
+void status_led_init(bool btstack_timer);
+
+// Any core.
+void status_led_set_state(status_led_state_t state);
+void status_led_set_error(bool error);
+// Core0: a frame was forwarded to the host.
+void status_led_on_activity(void);
+
+// Core1: renders the current pattern. Called by the timer, or by a loop that
+// owns core1 instead of BTstack.
+void status_led_tick(void);
+
+#endif  // STATUS_LED_H_
@@ -0,0 +1,60 @@
+#include "synth_input.h"
+
+#include <string.h>
+
+#include <pico/time.h>
+
+#include "comm.h"
+#include "debug.h"
+#include "frame_aggregator.h"
+#include "dualshock4.h"
+#include "status_led.h"
+
+static void synth_input_fill(ds4_report_t* report, uint32_t seq) {
+  *report = default_ds4_report();
+
+  // Slow sweeps, so the stream also looks sane in a gamepad tester.
+  uint8_t phase = seq >> 2;
+  report->left_stick_x = phase;
+  report->left_stick_y = ~phase;
+  report->right_stick_x = DS4_JOYSTICK_MID + (phase & 0x3f) - 0x20;
+  report->right_stick_y = DS4_JOYSTICK_MID - (phase & 0x3f) + 0x20;
+  report->button_south = (seq >> 8) & 1;
+  report->report_counter = seq & 0x3f;
+}
+
+void synth_input_run(uint32_t rate_hz) {
+  if (rate_hz < SYNTH_INPUT_MIN_RATE_HZ) {
+    rate_hz = SYNTH_INPUT_MIN_RATE_HZ;
+  } else if (rate_hz > SYNTH_INPUT_MAX_RATE_HZ) {
+    rate_hz = SYNTH_INPUT_MAX_RATE_HZ;
+  }
+  const uint32_t period_us = 1000000u / rate_hz;
+  PICO_INFO("Synthetic input: %u Hz\n", rate_hz);
+
+  ds4_report_t report;
+  absolute_time_t next = get_absolute_time();
+  uint32_t led_tick_us = time_us_32();
+  for (uint32_t seq = 0;; seq++) {
+    next = delayed_by_us(next, period_us);
+
+    synth_input_fill(&report, seq);
+
+    ds4_frame_t* frame = TRIPLE_BUFFER_WRITE_SLOT(g_ds4_shared);
+    frame->mode = DS4_BRIDGE_MODE_PASSTHROUGH;  // payload is already a USB report
+    frame->timestamp = time_us_32();
+    frame->rx_timestamp = frame->timestamp;
+    memcpy(&report.unknown5[SYNTH_INPUT_SEQ_OFFSET], &seq, sizeof(seq));
+    memcpy(&report.unknown5[SYNTH_INPUT_TIMESTAMP_OFFSET], &frame->timestamp, sizeof(frame->timestamp));
+    memcpy(frame->raw, &report, sizeof(frame->raw));
+    frame_aggregator_publish(frame);
+    g_ds4_counters.bt_reports++;
+
+    if (time_us_32() - led_tick_us >= STATUS_LED_TICK_MS * 1000u) {
+      led_tick_us = time_us_32();
+      status_led_tick();
+    }
+
+    sleep_until(next);
+  }
+}
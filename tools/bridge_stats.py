@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Poll live statistics from every connected bridge.
+
+Reads vendor feature reports 0xE3 and 0xE5 (see bridge_stats.h) at --rate Hz
+and prints one line per bridge every --interval seconds with rates computed
+from the counter deltas. --csv writes every sample instead. --connect prints the
+connection timeline of each bridge (0xE4, see connect_stats.h) and exits.
+"""
+import argparse
+import struct
+import sys
+import time
+
+import usb.core
+import usb.util
+
+VENDOR_ID  = 0x054c
+PRODUCT_ID = 0x09cc
+INTERFACE  = 0
+
+REPORT_STATS = 0xE3
+REPORT_CONNECT = 0xE4
+REPORT_LINK = 0xE5
+
+HID_GET_REPORT = 0x01
+HID_FEATURE    = 0x03
+
+HEADER_FMT = "<BBBBIIIIII"
+SPAN_NAMES = ["hci>l2cap", "l2cap>parsed", "parsed>pub", "pub>pickup", "pickup>submit", "submit>done", "hci>done",
+              "wake>hci"]
+STATS_FMT = HEADER_FMT + "HH" * len(SPAN_NAMES)
+COUNTERS = ["received", "forwarded", "overwritten", "usb_reports", "timeouts"]
+LINK_FMT = "<BIIIII"
+LINK_COUNTERS = ["out_sent", "out_merged", "out_dropped", "out_deferred", "crc_errors"]
+
+CONNECT_FMT = "<BBHIIIIIIIBBBII"
+PATH_NAMES = {0: "none", 1: "incoming", 2: "directed", 3: "inquiry"}
+PHASE_NAMES = {0: "fast", 1: "relaxed", 2: "streaming"}
+ARCH_NAMES = {0: "background", 1: "poll"}
+
+
+def get_report(dev, report_id, fmt):
+    length = struct.calcsize(fmt)
+    data = dev.ctrl_transfer(0xA1, HID_GET_REPORT, (HID_FEATURE << 8) | report_id, INTERFACE, length + 1)
+    return struct.unpack(fmt, bytes(data[1:1 + length]))
+
+
+def get_stats(dev):
+    values = get_report(dev, REPORT_STATS, STATS_FMT)
+    stats = {
+        "version": values[0],
+        "queue_depth": values[1],
+        "queue_max": values[2],
+        "cyw43_arch": ARCH_NAMES.get(values[3], values[3]),
+        "uptime_ms": values[4],
+    }
+    stats.update(zip(COUNTERS, values[5:10]))
+    lat = values[10:10 + 2 * len(SPAN_NAMES)]
+    stats.update(zip(LINK_COUNTERS, get_report(dev, REPORT_LINK, LINK_FMT)[1:]))
+    stats["latency"] = {name: (lat[2 * i], lat[2 * i + 1]) for i, name in enumerate(SPAN_NAMES)}
+    return stats
+
+
+def get_connect(dev):
+    (_, path, connections, boot_first, connect, ready, first, reconnect, page_scan, inquiry, phase, connect_phase,
+     sdp_cached, ready_sdp, ready_cached) = get_report(dev, REPORT_CONNECT, CONNECT_FMT)
+    return {"path": PATH_NAMES.get(path, path), "connections": connections, "boot_to_first_report_ms": boot_first,
+            "connect_ms": connect, "ready_ms": ready, "first_report_ms": first, "reconnect_ms": reconnect,
+            "page_scan_radio_ms": page_scan, "inquiry_radio_ms": inquiry, "scan_phase": PHASE_NAMES.get(phase, phase),
+            "connect_phase": PHASE_NAMES.get(connect_phase, connect_phase), "sdp_cached": bool(sdp_cached),
+            "acl_to_ready_sdp_ms": ready_sdp, "acl_to_ready_cached_ms": ready_cached}
+
+
+def print_connect(name, c):
+    def since(t, base):
+        return f"+{t - base}ms" if t and base else "-"
+
+    print(f"[{name}] {c['connections']} connection(s), last {c['path']}: connected at {c['connect_ms']}ms, "
+          f"ready {since(c['ready_ms'], c['connect_ms'])}, first report {since(c['first_report_ms'], c['connect_ms'])}; "
+          f"boot to first report {c['boot_to_first_report_ms'] or '-'}ms")
+    print(f"[{name}] reconnected {c['reconnect_ms']}ms after the disconnect, in the {c['connect_phase']} scan phase; "
+          f"scan now {c['scan_phase']}, radio time page scan {c['page_scan_radio_ms']}ms "
+          f"inquiry {c['inquiry_radio_ms']}ms")
+    print(f"[{name}] link up to ready: {c['acl_to_ready_sdp_ms'] or '-'}ms with SDP, "
+          f"{c['acl_to_ready_cached_ms'] or '-'}ms from the SDP cache (last: {'cache' if c['sdp_cached'] else 'SDP'})")
+
+
+def open_bridges():
+    bridges = []
+    for dev in usb.core.find(find_all=True, idVendor=VENDOR_ID, idProduct=PRODUCT_ID):
+        if dev.is_kernel_driver_active(INTERFACE):
+            dev.detach_kernel_driver(INTERFACE)
+        bridges.append((f"{dev.bus}-{dev.address}", dev))
+    return bridges
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--rate", type=float, default=100, help="polls per second")
+    parser.add_argument("--interval", type=float, default=1, help="seconds between summary lines")
+    parser.add_argument("--csv", action="store_true", help="print every sample as CSV")
+    parser.add_argument("--connect", action="store_true", help="print the connection timeline and exit")
+    args = parser.parse_args()
+
+    bridges = open_bridges()
+    if not bridges:
+        raise IOError("No bridge found")
+
+    if args.connect:
+        for name, dev in bridges:
+            print_connect(name, get_connect(dev))
+        return
+
+    if args.csv:
+        print("time,bridge,uptime_ms,queue_depth," + ",".join(COUNTERS + LINK_COUNTERS) + ","
+              + ",".join(f"{n}_p50,{n}_p99" for n in SPAN_NAMES))
+
+    last = {name: None for name, _ in bridges}
+    next_summary = time.monotonic() + args.interval
+    period = 1.0 / args.rate
+    while True:
+        now = time.monotonic()
+        for name, dev in bridges:
+            s = get_stats(dev)
+            if args.csv:
+                lat = ",".join(f"{p50},{p99}" for p50, p99 in s["latency"].values())
+                print(f"{now:.4f},{name},{s['uptime_ms']},{s['queue_depth']},"
+                      + ",".join(str(s[c]) for c in COUNTERS + LINK_COUNTERS) + "," + lat)
+            elif now >= next_summary:
+                prev = last[name]
+                if prev is not None:
+                    dt = max((s["uptime_ms"] - prev["uptime_ms"]) / 1000.0, 1e-3)
+                    rates = " ".join(f"{c}={(s[c] - prev[c]) / dt:7.1f}/s" for c in COUNTERS)
+                    out = " ".join(f"{c}=+{(s[c] - prev[c]) & 0xffffffff}" for c in LINK_COUNTERS)
+                    e2e = s["latency"]["hci>done"]
+                    wake = s["latency"]["wake>hci"]
+                    print(f"[{name}] {rates} queue={s['queue_depth']}/{s['queue_max']} {out} "
+                          f"e2e p50<={e2e[0]}us p99<={e2e[1]}us "
+                          f"{s['cyw43_arch']} wake>hci p50<={wake[0]}us p99<={wake[1]}us")
+                last[name] = s
+        if now >= next_summary:
+            next_summary += args.interval
+            sys.stdout.flush()
+        time.sleep(max(0.0, period - (time.monotonic() - now)))
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        pass
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Download the Bluetooth input trace recorded by the bridge.
+
+The bridge keeps the last ~32 KB of DS4 input reports in RAM (bt_trace.c).
+This freezes the ring, reads it through vendor feature reports 0xE0 / 0xE1
+and writes it to a file that host/bridge_host can replay:
+
+    tools/bt_trace.py dump capture.bin     # freeze + download
+    tools/bt_trace.py start                # clear the ring and record again
+    tools/bt_trace.py status
+"""
+import argparse
+import struct
+import sys
+
+import usb.core
+import usb.util
+
+VENDOR_ID  = 0x054c
+PRODUCT_ID = 0x09cc
+INTERFACE  = 0
+
+REPORT_STATUS = 0xE0
+REPORT_DATA   = 0xE1
+
+CMD_START  = 1
+CMD_FREEZE = 2
+CMD_REWIND = 3
+
+HID_GET_REPORT = 0x01
+HID_SET_REPORT = 0x09
+HID_FEATURE    = 0x03
+
+STATUS_FMT = "<BBHIII"
+STATE_NAMES = {0: "recording", 1: "frozen"}
+
+
+def get_feature(dev, report_id, length):
+    data = dev.ctrl_transfer(0xA1, HID_GET_REPORT, (HID_FEATURE << 8) | report_id, INTERFACE, length + 1)
+    # The first byte is the report ID.
+    return bytes(data[1:])
+
+
+def set_feature(dev, report_id, payload):
+    dev.ctrl_transfer(0x21, HID_SET_REPORT, (HID_FEATURE << 8) | report_id, INTERFACE, bytes([report_id]) + payload)
+
+
+def read_status(dev):
+    data = get_feature(dev, REPORT_STATUS, struct.calcsize(STATUS_FMT))
+    state, version, _, records, dropped, stream_len = struct.unpack_from(STATUS_FMT, data)
+    return {"state": STATE_NAMES.get(state, state), "version": version, "records": records,
+            "dropped": dropped, "bytes": stream_len}
+
+
+def dump(dev, path):
+    set_feature(dev, REPORT_STATUS, bytes([CMD_FREEZE]))
+    status = read_status(dev)
+    out = bytearray()
+    while True:
+        chunk = get_feature(dev, REPORT_DATA, 63)
+        n = chunk[0]
+        if n == 0:
+            break
+        out += chunk[1:1 + n]
+    with open(path, "wb") as f:
+        f.write(out)
+    print(f"{path}: {status['records']} reports, {len(out)} bytes ({status['dropped']} older reports dropped)")
+    if len(out) != status["bytes"]:
+        print(f"warning: expected {status['bytes']} bytes", file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("command", choices=["status", "start", "dump"])
+    parser.add_argument("file", nargs="?", default="bt_trace.bin")
+    args = parser.parse_args()
+
+    dev = usb.core.find(idVendor=VENDOR_ID, idProduct=PRODUCT_ID)
+    if dev is None:
+        raise IOError("Bridge not found")
+
+    reattach = dev.is_kernel_driver_active(INTERFACE)
+    if reattach:
+        dev.detach_kernel_driver(INTERFACE)
+    try:
+        if args.command == "status":
+            print(read_status(dev))
+        elif args.command == "start":
+            set_feature(dev, REPORT_STATUS, bytes([CMD_START]))
+            print(read_status(dev))
+        else:
+            dump(dev, args.file)
+    finally:
+        usb.util.dispose_resources(dev)
+        if reattach:
+            dev.attach_kernel_driver(INTERFACE)
+
+
+if __name__ == "__main__":
+    main()
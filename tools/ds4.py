@@ -1,9 +1,93 @@
 #!/usr/bin/env python3
+"""Print the input reports of the bridge.
+
+With --loopback, the bridge must run DS4_BRIDGE_MODE_SYNTHETIC: every report
+then carries a sequence number and the core1 publish time (synth_input.h).
+Gaps, duplicates, latency and jitter are printed every second and on Ctrl+C.
+Latency is host receive time minus device time, relative to the smallest
+offset seen, so it shows the spread on top of the fixed path delay.
+"""
+import argparse
 import usb.core
 import usb.util
 import struct
 import time
 
+# Offsets into the interrupt transfer: report ID, then ds4_report_t, whose
+# unknown5 starts at byte 51.
+SYNTH_SEQ_OFFSET = 1 + 51 + 0
+SYNTH_TIMESTAMP_OFFSET = 1 + 51 + 4
+
+
+def percentiles(values, points=(50, 90, 99, 99.9)):
+    if not values:
+        return "-"
+    values = sorted(values)
+    parts = []
+    for p in points:
+        i = min(len(values) - 1, int(len(values) * p / 100))
+        parts.append(f"p{p:g}={values[i]:.0f}")
+    parts.append(f"max={values[-1]:.0f}")
+    return " ".join(parts)
+
+
+class Loopback:
+    def __init__(self):
+        self.reports = 0
+        self.gaps = 0
+        self.missing = 0
+        self.duplicates = 0
+        self.reordered = 0
+        self.last_seq = None
+        self.last_rx = None
+        self.first_offset = 0
+        self.offsets_us = []
+        self.interval_us = []
+
+    def add(self, data, rx_us):
+        seq, dev_us = struct.unpack_from("<II", data, SYNTH_SEQ_OFFSET)
+        self.reports += 1
+
+        if self.last_seq is not None:
+            delta = (seq - self.last_seq) & 0xFFFFFFFF
+            if delta == 0:
+                self.duplicates += 1
+                return
+            if delta >= 0x80000000:
+                self.reordered += 1
+                return
+            if delta > 1:
+                self.gaps += 1
+                self.missing += delta - 1
+        self.last_seq = seq
+
+        # The device clock is 32 bit, so offsets are kept relative to the
+        # first one, which also survives a device timer wrap.
+        offset = (rx_us - dev_us) & 0xFFFFFFFF
+        if self.offsets_us:
+            delta = (offset - self.first_offset) & 0xFFFFFFFF
+            self.offsets_us.append(delta - 0x100000000 if delta >= 0x80000000 else delta)
+        else:
+            self.first_offset = offset
+            self.offsets_us.append(0)
+
+        if self.last_rx is not None:
+            self.interval_us.append(rx_us - self.last_rx)
+        self.last_rx = rx_us
+
+    def summary(self):
+        base = min(self.offsets_us, default=0)
+        latency_us = [o - base for o in self.offsets_us]
+        return (f"{self.reports} reports, {self.gaps} gaps ({self.missing} frames), "
+                f"{self.duplicates} duplicates, {self.reordered} out of order\n"
+                f"  latency us: {percentiles(latency_us)}\n"
+                f"  interval us: {percentiles(self.interval_us)}")
+
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument("--loopback", action="store_true", help="analyse synthetic frames instead of printing reports")
+args = parser.parse_args()
+
 VENDOR_ID  = 0x054c
 PRODUCT_ID = 0x09cc
 
@@ -37,12 +121,21 @@ print("Reading reports (Ctrl+C to stop)…")
 
 # 4) 읽기 루프
 start = time.monotonic()
+loopback = Loopback() if args.loopback else None
+next_summary = start + 1
 try:
     while True:
         # bEndpointAddress, wMaxPacketSize
         data = dev.read(sensor_ep.bEndpointAddress, sensor_ep.wMaxPacketSize, timeout=5000)
         t = time.monotonic() - start
 
+        if loopback:
+            loopback.add(data, time.monotonic_ns() // 1000)
+            if time.monotonic() >= next_summary:
+                next_summary += 1
+                print(f"{t:6.1f}s | {loopback.summary()}")
+            continue
+
         # 스틱 축
         lx, ly = data[1], data[2]
         rx, ry = data[3], data[4]
@@ -67,3 +160,5 @@ try:
 
 except KeyboardInterrupt:
     print("\nStopped by user.")
+    if loopback:
+        print(loopback.summary())
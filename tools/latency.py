@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""Print the bridge's per-stage latency histograms.
+
+Reads vendor feature report 0xE2 page by page (see latency.h) and prints one
+log2 histogram per stage pair. Pass --reset to clear the histograms first,
+--watch N to refresh every N seconds.
+"""
+import argparse
+import struct
+import time
+
+import usb.core
+import usb.util
+
+VENDOR_ID  = 0x054c
+PRODUCT_ID = 0x09cc
+INTERFACE  = 0
+
+REPORT_LATENCY = 0xE2
+CMD_REWIND = 0
+CMD_RESET  = 1
+
+HID_GET_REPORT = 0x01
+HID_SET_REPORT = 0x09
+HID_FEATURE    = 0x03
+
+PAGE_FMT = "<BBBBIII8I"
+SPAN_NAMES = [
+    "hci -> l2cap",
+    "l2cap -> parsed",
+    "parsed -> publish",
+    "publish -> pickup",
+    "pickup -> submit",
+    "submit -> complete",
+    "hci -> complete",
+    "radio wake -> hci",
+]
+
+
+def get_feature(dev, report_id, length):
+    data = dev.ctrl_transfer(0xA1, HID_GET_REPORT, (HID_FEATURE << 8) | report_id, INTERFACE, length + 1)
+    return bytes(data[1:])
+
+
+def set_feature(dev, report_id, payload):
+    dev.ctrl_transfer(0x21, HID_SET_REPORT, (HID_FEATURE << 8) | report_id, INTERFACE, bytes([report_id]) + payload)
+
+
+def read_histograms(dev):
+    set_feature(dev, REPORT_LATENCY, bytes([CMD_REWIND]))
+    spans = {}
+    while True:
+        page = struct.unpack(PAGE_FMT, get_feature(dev, REPORT_LATENCY, struct.calcsize(PAGE_FMT)))
+        span, span_count, first, bucket_count, samples, max_us, mean_us = page[:7]
+        hist = spans.setdefault(span, {"samples": samples, "max": max_us, "mean": mean_us,
+                                       "buckets": [0] * bucket_count})
+        hist["buckets"][first:first + 8] = page[7:]
+        if span == span_count - 1 and first + 8 >= bucket_count:
+            return spans
+
+
+def bucket_label(i):
+    if i == 0:
+        return "0"
+    return f"{1 << (i - 1)}-{(1 << i) - 1}"
+
+
+def print_histograms(spans):
+    for span, hist in sorted(spans.items()):
+        name = SPAN_NAMES[span] if span < len(SPAN_NAMES) else f"span {span}"
+        print(f"{name:20s} n={hist['samples']:<10d} mean={hist['mean']:>6d} us  max={hist['max']:>6d} us")
+        total = max(hist["samples"], 1)
+        last = len(hist["buckets"]) - 1
+        for i, count in enumerate(hist["buckets"]):
+            if count == 0:
+                continue
+            label = bucket_label(i) if i < last else f">={1 << (i - 1)}"
+            bar = "#" * int(40 * count / total)
+            print(f"  {label:>12s} us {count:>10d} {bar}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--reset", action="store_true")
+    parser.add_argument("--watch", type=float, default=0)
+    args = parser.parse_args()
+
+    dev = usb.core.find(idVendor=VENDOR_ID, idProduct=PRODUCT_ID)
+    if dev is None:
+        raise IOError("Bridge not found")
+
+    reattach = dev.is_kernel_driver_active(INTERFACE)
+    if reattach:
+        dev.detach_kernel_driver(INTERFACE)
+    try:
+        if args.reset:
+            set_feature(dev, REPORT_LATENCY, bytes([CMD_RESET]))
+        while True:
+            print_histograms(read_histograms(dev))
+            if args.watch <= 0:
+                break
+            time.sleep(args.watch)
+            print()
+    finally:
+        usb.util.dispose_resources(dev)
+        if reattach:
+            dev.attach_kernel_driver(INTERFACE)
+
+
+if __name__ == "__main__":
+    main()
@@ -2,8 +2,14 @@
 #include <pico/cyw43_arch.h>
 #include <tusb.h>
 
+#include "bridge_stats.h"
+#include "bt_trace.h"
+#include "connect_stats.h"
 #include "debug.h"
 #include "dualshock4.h"
+#include "host_output.h"
+#include "latency.h"
+#include "usb_scheduler.h"
 
 #define min(x, y) (x) < (y) ? (x) : (y)
 #define max(x, y) (x) > (y) ? (x) : (y)
@@ -27,6 +33,12 @@
 #define DS4_GET_SIGNATURE_NONCE 0xF1    // Get Signature Nonce
 #define DS4_GET_SIGNING_STATE 0xF2      // Get Signing State
 #define DS4_RESET_AUTH 0xF3             // Unknown (PS4 Report 0xF3)
+#define BRIDGE_BT_TRACE_STATUS 0xE0     // Bridge: BT trace status / command
+#define BRIDGE_BT_TRACE_DATA 0xE1       // Bridge: BT trace read-out
+#define BRIDGE_LATENCY 0xE2             // Bridge: latency histogram page / command
+#define BRIDGE_STATS 0xE3               // Bridge: live statistics
+#define BRIDGE_CONNECT_STATS 0xE4       // Bridge: connection timeline
+#define BRIDGE_LINK_STATS 0xE5          // Bridge: Bluetooth link counters
 
 bool is_ds4_initialized = false;
 bool is_usb_mounted = false;
@@ -298,6 +310,35 @@ uint8_t const ds4_hid_report_desc[] = {
     0x95, 0x07,        //   Report Count (7)
     0xB1, 0x02,        //
     0xC0,              // End Collection
+
+    0x06, 0xE0, 0xFF,  // Usage Page (Vendor Defined 0xFFE0)
+    0x09, 0x01,        // Usage (0x01)
+    0xA1, 0x01,        // Collection (Application)
+    0x85, 0xE0,        //   Report ID (-32) Bridge BT trace status
+    0x09, 0x01,        //   Usage (0x01)
+    0x95, 0x10,        //   Report Count (16)
+    0xB1, 0x02,        //
+    0x85, 0xE1,        //   Report ID (-31) Bridge BT trace data
+    0x09, 0x02,        //   Usage (0x02)
+    0x95, 0x3F,        //   Report Count (63)
+    0xB1, 0x02,        //
+    0x85, 0xE2,        //   Report ID (-30) Bridge latency histograms
+    0x09, 0x03,        //   Usage (0x03)
+    0x95, 0x30,        //   Report Count (48)
+    0xB1, 0x02,        //
+    0x85, 0xE3,        //   Report ID (-29) Bridge statistics
+    0x09, 0x04,        //   Usage (0x04)
+    0x95, 0x3C,        //   Report Count (60)
+    0xB1, 0x02,        //
+    0x85, 0xE4,        //   Report ID (-28) Bridge connection timeline
+    0x09, 0x05,        //   Usage (0x05)
+    0x95, 0x2B,        //   Report Count (43)
+    0xB1, 0x02,        //
+    0x85, 0xE5,        //   Report ID (-27) Bridge Bluetooth link counters
+    0x09, 0x06,        //   Usage (0x06)
+    0x95, 0x15,        //   Report Count (21)
+    0xB1, 0x02,        //
+    0xC0,              // End Collection
 };
 
 #define DS4_CONFIG1_DESC_SIZE (9 + 9 + 9 + 7 + 7)
@@ -337,7 +378,7 @@ static const uint8_t ds4_configuration_descriptor[] = {
     GAMEPAD_ENDPOINT | 0x80,  // bEndpointAddress
     0x03,                     // bmAttributes (0x03=intr)
     GAMEPAD_SIZE, 0,          // wMaxPacketSize
-    4,                        // bInterval (4 ms)
+    USB_SCHED_POLL_INTERVAL_MS,  // bInterval
     0x07, 0x05, 0x03, 0x03, 0x40, 0x00, 0x01};
 
 // --- String Descriptors ---
@@ -410,8 +451,11 @@ uint16_t tud_hid_get_report_cb(uint8_t instance,
     return 0;
   }
 
-  PICO_INFO("Got hid report: id=%d, type=%d, size=%d\n", report_id, report_type,
-            reqlen);
+  // Bridge reports (0xE0-0xEF) are polled at a high rate, don't log them.
+  if ((report_id & 0xF0) != 0xE0) {
+    PICO_INFO("Got hid report: id=%d, type=%d, size=%d\n", report_id,
+              report_type, reqlen);
+  }
 
   uint16_t responseLen = 0;
   switch (report_id) {
@@ -481,6 +525,50 @@ uint16_t tud_hid_get_report_cb(uint8_t instance,
       memcpy(buffer, reset_auth, responseLen);
       return responseLen;
     }
+    case BRIDGE_BT_TRACE_STATUS: {
+      bt_trace_status_t status;
+      bt_trace_get_status(&status);
+      responseLen = min(reqlen, sizeof(status));
+      memcpy(buffer, &status, responseLen);
+      return responseLen;
+    }
+    case BRIDGE_BT_TRACE_DATA: {
+      // byte 0: number of valid trace bytes that follow (0 = end of trace)
+      if (reqlen < 2) {
+        return 0;
+      }
+      responseLen = min(reqlen, 63);
+      buffer[0] = bt_trace_read(&buffer[1], responseLen - 1);
+      return responseLen;
+    }
+    case BRIDGE_STATS: {
+      bridge_stats_report_t stats;
+      bridge_stats_fill(&stats);
+      responseLen = min(reqlen, sizeof(stats));
+      memcpy(buffer, &stats, responseLen);
+      return responseLen;
+    }
+    case BRIDGE_LINK_STATS: {
+      bridge_link_stats_report_t stats;
+      bridge_stats_fill_link(&stats);
+      responseLen = min(reqlen, sizeof(stats));
+      memcpy(buffer, &stats, responseLen);
+      return responseLen;
+    }
+    case BRIDGE_CONNECT_STATS: {
+      connect_stats_report_t stats;
+      connect_stats_fill(&stats);
+      responseLen = min(reqlen, sizeof(stats));
+      memcpy(buffer, &stats, responseLen);
+      return responseLen;
+    }
+    case BRIDGE_LATENCY: {
+      latency_page_t page;
+      latency_read_page(&page);
+      responseLen = min(reqlen, sizeof(page));
+      memcpy(buffer, &page, responseLen);
+      return responseLen;
+    }
     default:
       PICO_ERROR("Unknown report ID %d\n", report_id);
       break;
@@ -516,10 +604,37 @@ void tud_hid_set_report_cb(uint8_t instance,
 
   // printf("tud_hid_set_report_cb: ID=%d, Type=%d, Size=%d\n", report_id,
   // report_type, bufsize);
+  if (report_type == HID_REPORT_TYPE_FEATURE &&
+      report_id == BRIDGE_BT_TRACE_STATUS && bufsize >= 1) {
+    bt_trace_command((bt_trace_cmd_t)buffer[0]);
+    return;
+  }
+  if (report_type == HID_REPORT_TYPE_FEATURE && report_id == BRIDGE_LATENCY &&
+      bufsize >= 1) {
+    latency_command((latency_cmd_t)buffer[0]);
+    return;
+  }
+
   ds4_feature_output_report_t feature;
   if (report_type == HID_REPORT_TYPE_OUTPUT) {
-    if (report_id == 0 && !is_ds4_initialized) {
-      memcpy(&feature, buffer, bufsize);
+    // Report ID 0: the ID is the first byte of the buffer (interrupt OUT).
+    memset(&feature, 0, sizeof(feature));
+    if (report_id == 0) {
+      memcpy(&feature, buffer, min(bufsize, sizeof(feature)));
+    } else {
+      feature.reportID = report_id;
+      memcpy((uint8_t*)&feature + 1, buffer, min(bufsize, sizeof(feature) - 1));
+    }
+
+    // Only the latest values are kept; core1 forwards them to the controller
+    // at its own pace (host_output.h).
+    if (feature.reportID == DS4_SET_FEATURE_STATE) {
+      if (feature.enableUpdateRumble) {
+        host_output_set_rumble(feature.rumbleRight, feature.rumbleLeft);
+      }
+      if (feature.enableUpdateLED) {
+        host_output_set_lightbar(feature.ledRed, feature.ledGreen, feature.ledBlue);
+      }
     }
     // printf("Feature Report:\n");
     // printf("Report ID: %d\n", feature.reportID);
@@ -569,6 +684,9 @@ void tud_umount_cb(void) {
 void tud_hid_report_complete_cb(uint8_t instance,
                                 uint8_t const* report,
                                 uint16_t len) {
+  uint32_t now_us = time_us_32();
+  latency_on_complete(now_us);
+  usb_scheduler_on_complete(now_us);
   report_in_flight = false;
 }
 
@@ -0,0 +1,95 @@
+#include "usb_scheduler.h"
+
+#include <string.h>
+
+static struct {
+  uint32_t anchor_us;  // smoothed time of a past host poll
+  uint32_t last_complete_us;
+  uint32_t samples;
+
+  bool pending;  // a report carrying a frame is waiting for the host
+  uint32_t pending_frame_us;
+} s_sched;
+
+static usb_scheduler_stats_t s_stats;
+
+void usb_scheduler_init(void) {
+  memset(&s_sched, 0, sizeof(s_sched));
+  memset(&s_stats, 0, sizeof(s_stats));
+  s_stats.period_us = USB_SCHED_POLL_INTERVAL_US;
+}
+
+bool usb_scheduler_is_due(uint32_t now_us, uint32_t* next_due_us) {
+  if (!s_stats.locked) {
+    return true;
+  }
+
+  if (now_us - s_sched.last_complete_us > USB_SCHED_UNLOCK_US) {
+    // Host stopped reading (suspend, link loss, ...). Fall back to immediate
+    // submission; the phase is re-learned from the next completions.
+    s_stats.locked = false;
+    s_sched.samples = 0;
+    return true;
+  }
+
+  uint32_t polls_since_anchor = (now_us - s_sched.anchor_us) / USB_SCHED_POLL_INTERVAL_US;
+  uint32_t next_poll_us = s_sched.anchor_us + (polls_since_anchor + 1) * USB_SCHED_POLL_INTERVAL_US;
+  uint32_t submit_at_us = next_poll_us - USB_SCHED_GUARD_US;
+
+  if ((int32_t)(now_us - submit_at_us) >= 0) {
+    return true;
+  }
+
+  *next_due_us = submit_at_us;
+  return false;
+}
+
+void usb_scheduler_on_submit(uint32_t frame_timestamp_us, bool has_frame) {
+  s_sched.pending = has_frame;
+  s_sched.pending_frame_us = frame_timestamp_us;
+}
+
+void usb_scheduler_on_complete(uint32_t now_us) {
+  s_stats.polls++;
+
+  if (s_sched.pending) {
+    uint32_t age_us = now_us - s_sched.pending_frame_us;
+    uint32_t bucket = age_us / USB_SCHED_AGE_BUCKET_US;
+    if (bucket >= USB_SCHED_AGE_BUCKETS) {
+      bucket = USB_SCHED_AGE_BUCKETS - 1;
+    }
+    s_stats.age_hist[bucket]++;
+    if (age_us > s_stats.age_max_us) {
+      s_stats.age_max_us = age_us;
+    }
+    s_sched.pending = false;
+  }
+
+  int32_t since_anchor = (int32_t)(now_us - s_sched.anchor_us);
+  if (s_sched.samples == 0 || since_anchor < 0 || now_us - s_sched.last_complete_us > USB_SCHED_UNLOCK_US) {
+    // (Re)start phase tracking from this poll.
+    s_sched.anchor_us = now_us;
+    s_sched.samples = 1;
+    s_stats.locked = false;
+  } else {
+    // Snap to the nearest predicted poll and nudge the anchor by 1/8 of the
+    // error. This tracks crystal drift between host and device while
+    // filtering out the jitter of tud_task() picking up the completion.
+    uint32_t n = ((uint32_t)since_anchor + USB_SCHED_POLL_INTERVAL_US / 2) / USB_SCHED_POLL_INTERVAL_US;
+    uint32_t predicted_us = s_sched.anchor_us + n * USB_SCHED_POLL_INTERVAL_US;
+    int32_t error_us = (int32_t)(now_us - predicted_us);
+
+    s_sched.anchor_us = predicted_us + error_us / 8;
+    s_stats.phase_error_us = error_us;
+    if (++s_sched.samples >= USB_SCHED_LOCK_SAMPLES) {
+      s_stats.locked = true;
+    }
+  }
+
+  s_sched.last_complete_us = now_us;
+  s_stats.phase_us = s_sched.anchor_us % USB_SCHED_POLL_INTERVAL_US;
+}
+
+const usb_scheduler_stats_t* usb_scheduler_get_stats(void) {
+  return &s_stats;
+}
@@ -0,0 +1,58 @@
+#ifndef USB_SCHEDULER_H_
+#define USB_SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * SOF-phase-locked report scheduler
+ * ---------------------------------
+ * The host polls the gamepad IN endpoint every bInterval. A report queued
+ * right after a poll sits in the endpoint buffer for almost a full interval
+ * and reaches the host stale. The scheduler learns where the host polls fall
+ * from the report completion times and tells the USB loop to hold frames until
+ * just before the next poll, so the host always reads the freshest frame.
+ *
+ * All functions must be called from core0 (USB loop / TinyUSB callbacks).
+ */
+
+// bInterval of the gamepad IN endpoint. Above 1000 / USB_SCHED_POLL_INTERVAL_MS
+// Bluetooth reports per second, frames are coalesced; 1 forwards up to 1 kHz.
+#ifndef USB_SCHED_POLL_INTERVAL_MS
+#define USB_SCHED_POLL_INTERVAL_MS 4
+#endif
+#define USB_SCHED_POLL_INTERVAL_US (USB_SCHED_POLL_INTERVAL_MS * 1000)
+#define USB_SCHED_GUARD_US 500  // submit this long before the predicted poll
+#define USB_SCHED_LOCK_SAMPLES 8         // completions needed before holding frames
+#define USB_SCHED_UNLOCK_US 100000       // drop the lock if no completion for this long
+
+#define USB_SCHED_AGE_BUCKET_US 250  // width of each "frame age at poll" bucket
+#define USB_SCHED_AGE_BUCKETS 16     // last bucket collects everything above
+
+typedef struct {
+  bool locked;
+  uint32_t period_us;
+  uint32_t phase_us;        // predicted poll time modulo period_us
+  int32_t phase_error_us;   // last measured poll time minus prediction
+  uint32_t polls;           // completions observed
+  uint32_t age_max_us;      // oldest frame the host has read
+  uint32_t age_hist[USB_SCHED_AGE_BUCKETS];
+} usb_scheduler_stats_t;
+
+void usb_scheduler_init(void);
+
+// Returns true if a report should be submitted now. Otherwise *next_due_us is
+// set to the time_us_32() value at which the loop should check again.
+bool usb_scheduler_is_due(uint32_t now_us, uint32_t* next_due_us);
+
+// Called after tud_hid_report() succeeded. frame_timestamp_us is the publish
+// time of the frame carried by the report; has_frame is false for synthetic
+// reports (e.g. neutral report on timeout).
+void usb_scheduler_on_submit(uint32_t frame_timestamp_us, bool has_frame);
+
+// Called from tud_hid_report_complete_cb(), i.e. when the host read the report.
+void usb_scheduler_on_complete(uint32_t now_us);
+
+const usb_scheduler_stats_t* usb_scheduler_get_stats(void);
+
+#endif  // USB_SCHEDULER_H_